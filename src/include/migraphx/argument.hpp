@@ -5,6 +5,7 @@
 #include <migraphx/raw_data.hpp>
 #include <migraphx/config.hpp>
 #include <functional>
+#include <memory>
 #include <utility>
 
 namespace migraphx {
@@ -23,9 +24,9 @@ struct argument : raw_data<argument>
 
     argument(const shape& s) : m_shape(s)
     {
-        std::vector<char> buffer(s.bytes());
-        // TODO: Move vector
-        data = [=]() mutable { return buffer.data(); };
+        // Copies of the argument share the buffer
+        std::shared_ptr<char> buffer(new char[s.bytes()](), std::default_delete<char[]>());
+        data = [=]() { return buffer.get(); };
     }
 
     argument(shape s, std::function<char*()> d) : data(std::move(d)), m_shape(std::move(s)) {}
@@ -119,6 +119,13 @@ auto pack(Ts... xs)
     return [=](auto f) { return f(xs...); };
 }
 
+/// Concatenate the values of two packs into one pack
+template <class P1, class P2>
+auto pack_join(P1 p1, P2 p2)
+{
+    return p1([=](auto... xs) { return p2([=](auto... ys) { return pack(xs..., ys...); }); });
+}
+
 template <class F, class T>
 auto fold_impl(F&&, T&& x)
 {
@@ -57,6 +57,9 @@ struct literal : raw_data<literal>
         std::copy(x, x + s.bytes(), buffer.get());
     }
 
+    /// Use the data in the buffer without copying it
+    literal(const shape& s, std::shared_ptr<char> b) : buffer(std::move(b)), m_shape(s) {}
+
     /// Whether data is available
     bool empty() const { return this->buffer == nullptr; }
 
@@ -65,11 +68,19 @@ struct literal : raw_data<literal>
 
     const shape& get_shape() const { return this->m_shape; }
 
-    /// Convert the data to an argument
+    /// Use the data of the argument without copying it. The argument needs
+    /// to own its data, or keep it alive, such as the result of an operator.
+    explicit literal(const argument& a) : m_shape(a.get_shape())
+    {
+        auto holder = std::make_shared<argument>(a);
+        buffer      = std::shared_ptr<char>(holder, holder->data());
+    }
+
+    /// Convert the data to an argument, which shares the data of the literal
     argument get_argument() const
     {
-        std::vector<char> b(buffer.get(), buffer.get() + m_shape.bytes());
-        return {m_shape, [b]() mutable { return b.data(); }};
+        auto b = buffer;
+        return {m_shape, [b]() { return b.get(); }};
     }
 
     private:
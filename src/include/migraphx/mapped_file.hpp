@@ -0,0 +1,19 @@
+#ifndef MIGRAPHX_GUARD_RTGLIB_MAPPED_FILE_HPP
+#define MIGRAPHX_GUARD_RTGLIB_MAPPED_FILE_HPP
+
+#include <migraphx/config.hpp>
+#include <memory>
+#include <string>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+
+/// Map a file read-only in memory, so its contents can be used without a
+/// copy. The mapping is released when the last pointer to it is gone, and
+/// `size` is set to the size of the file.
+std::shared_ptr<char> map_file(const std::string& filename, std::size_t& size);
+
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef MIGRAPHX_GUARD_OPERATORS_DEQUANTIZELINEAR_HPP
+#define MIGRAPHX_GUARD_OPERATORS_DEQUANTIZELINEAR_HPP
+
+#include <migraphx/operation.hpp>
+#include <migraphx/check_shapes.hpp>
+#include <migraphx/argument.hpp>
+#include <migraphx/shape_for_each.hpp>
+#include <migraphx/config.hpp>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace op {
+
+/// Convert int8 values, or the int32 results of the quantized operators, back
+/// to float as `(x - zero_point) * scale`
+struct dequantizelinear
+{
+    float scale    = 1.0f;
+    int zero_point = 0;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return pack(f(self.scale, "scale"), f(self.zero_point, "zero_point"));
+    }
+
+    std::string name() const { return "dequantizelinear"; }
+    shape compute_shape(std::vector<shape> inputs) const
+    {
+        check_shapes{inputs, *this}.has(1);
+        auto t = inputs.front().type();
+        if(t != shape::int8_type and t != shape::int32_type)
+            MIGRAPHX_THROW("DEQUANTIZELINEAR: the input must be int8 or int32");
+        return {shape::float_type, inputs.front().lens()};
+    }
+
+    auto apply() const
+    {
+        auto s = scale;
+        auto z = float(zero_point);
+        return [s, z](auto x) { return (float(x) - z) * s; };
+    }
+
+    argument compute(const shape& output_shape, std::vector<argument> args) const
+    {
+        argument result{output_shape};
+        auto output = result.get<float>();
+        auto f      = apply();
+        args[0].visit([&](auto input) {
+            shape_for_each(output_shape, [&](const auto& idx) {
+                output(idx.begin(), idx.end()) = f(input(idx.begin(), idx.end()));
+            });
+        });
+        return result;
+    }
+};
+
+} // namespace op
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
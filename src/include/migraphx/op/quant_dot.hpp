@@ -0,0 +1,30 @@
+#ifndef MIGRAPHX_GUARD_OPERATORS_QUANT_DOT_HPP
+#define MIGRAPHX_GUARD_OPERATORS_QUANT_DOT_HPP
+
+#include <migraphx/op/dot.hpp>
+#include <migraphx/operation.hpp>
+#include <migraphx/check_shapes.hpp>
+#include <migraphx/config.hpp>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace op {
+
+/// Multiply int8 matrices, accumulating the products in int32
+struct quant_dot
+{
+    std::string name() const { return "quant_dot"; }
+    shape compute_shape(std::vector<shape> inputs) const
+    {
+        check_shapes{inputs, *this}.has(2).same_type();
+        if(inputs.front().type() != shape::int8_type)
+            MIGRAPHX_THROW("QUANT_DOT: only int8 matrices are supported");
+        return {shape::int32_type, dot{}.compute_shape(inputs).lens()};
+    }
+};
+
+} // namespace op
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
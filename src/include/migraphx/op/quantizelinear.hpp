@@ -0,0 +1,67 @@
+#ifndef MIGRAPHX_GUARD_OPERATORS_QUANTIZELINEAR_HPP
+#define MIGRAPHX_GUARD_OPERATORS_QUANTIZELINEAR_HPP
+
+#include <migraphx/operation.hpp>
+#include <migraphx/check_shapes.hpp>
+#include <migraphx/argument.hpp>
+#include <migraphx/shape_for_each.hpp>
+#include <migraphx/config.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace op {
+
+/// Quantize values to int8 as `round(x / scale) + zero_point`, saturated to
+/// the range of int8. Ties are rounded to even.
+struct quantizelinear
+{
+    float scale    = 1.0f;
+    int zero_point = 0;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return pack(f(self.scale, "scale"), f(self.zero_point, "zero_point"));
+    }
+
+    std::string name() const { return "quantizelinear"; }
+    shape compute_shape(std::vector<shape> inputs) const
+    {
+        check_shapes{inputs, *this}.has(1);
+        if(inputs.front().type() == shape::int8_type)
+            MIGRAPHX_THROW("QUANTIZELINEAR: the input is already quantized");
+        return {shape::int8_type, inputs.front().lens()};
+    }
+
+    auto apply() const
+    {
+        auto s = scale;
+        auto z = float(zero_point);
+        return [s, z](auto x) {
+            auto q = std::nearbyint(float(x) / s) + z;
+            return static_cast<int8_t>(std::min(std::max(q, -128.0f), 127.0f));
+        };
+    }
+
+    argument compute(const shape& output_shape, std::vector<argument> args) const
+    {
+        argument result{output_shape};
+        auto output = result.get<int8_t>();
+        auto f      = apply();
+        args[0].visit([&](auto input) {
+            shape_for_each(output_shape, [&](const auto& idx) {
+                output(idx.begin(), idx.end()) = f(input(idx.begin(), idx.end()));
+            });
+        });
+        return result;
+    }
+};
+
+} // namespace op
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
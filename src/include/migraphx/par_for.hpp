@@ -1,6 +1,7 @@
 #ifndef MIGRAPHX_GUARD_RTGLIB_PAR_FOR_HPP
 #define MIGRAPHX_GUARD_RTGLIB_PAR_FOR_HPP
 
+#include <migraphx/thread_pool.hpp>
 #include <thread>
 #include <cmath>
 #include <algorithm>
@@ -37,27 +38,18 @@ void par_for_impl(std::size_t n, std::size_t threadsize, F f)
     }
     else
     {
-        std::vector<joinable_thread> threads(threadsize);
-// Using const here causes gcc 5 to ICE
-#if(!defined(__GNUC__) || __GNUC__ != 5)
-        const
-#endif
-            std::size_t grainsize = std::ceil(static_cast<double>(n) / threads.size());
-
-        std::size_t work = 0;
-        std::generate(threads.begin(), threads.end(), [=, &work] {
-            auto result = joinable_thread([=] {
-                std::size_t start = work;
-                std::size_t last  = std::min(n, work + grainsize);
+        // Split the work into more chunks than threads so the threads that
+        // finish early can pick up the remaining work
+        const std::size_t chunks_per_thread = 4;
+        std::size_t grainsize =
+            std::ceil(static_cast<double>(n) / (threadsize * chunks_per_thread));
+        get_thread_pool().parallel_for(
+            n, grainsize, threadsize, [&](std::size_t start, std::size_t last) {
                 for(std::size_t i = start; i < last; i++)
                 {
                     f(i);
                 }
             });
-            work += grainsize;
-            return result;
-        });
-        assert(work >= n);
     }
 }
 
@@ -65,7 +57,7 @@ template <class F>
 void par_for(std::size_t n, std::size_t min_grain, F f)
 {
     const auto threadsize =
-        std::min<std::size_t>(std::thread::hardware_concurrency(), n / min_grain);
+        std::min<std::size_t>(get_thread_pool().size(), n / min_grain);
     par_for_impl(n, threadsize, f);
 }
 
@@ -0,0 +1,30 @@
+#ifndef MIGRAPHX_GUARD_RTGLIB_PAR_SHAPE_FOR_EACH_HPP
+#define MIGRAPHX_GUARD_RTGLIB_PAR_SHAPE_FOR_EACH_HPP
+
+#include <migraphx/shape_for_each.hpp>
+#include <migraphx/par_for.hpp>
+#include <migraphx/config.hpp>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+
+/// Parallel version of for_each_offset, which splits the elements into
+/// chunks and only computes the starting index of each chunk
+template <class... Shapes>
+auto par_for_each_offset(const shape& s, const Shapes&... ss)
+{
+    return [=](auto f) {
+        offset_walker<sizeof...(Shapes) + 1> w{{{s, ss...}}};
+        const std::size_t n         = w.elements();
+        const std::size_t grainsize = 4096;
+        const std::size_t chunks    = (n + grainsize - 1) / grainsize;
+        par_for(chunks, 1, [&](std::size_t chunk) {
+            w(chunk * grainsize, std::min(n, (chunk + 1) * grainsize), f);
+        });
+    };
+}
+
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
@@ -122,6 +122,11 @@ struct program
 
     void annotate(std::ostream& os, std::function<void(instruction_ref)> a) const;
 
+    /// Save the program, including the memory plan of a compiled program, to a file
+    void save(const std::string& filename) const;
+
+    friend program load(const std::string& filename, const target& t);
+
     friend std::ostream& operator<<(std::ostream& os, const program& p);
     friend bool operator==(const program& x, const program& y);
     friend bool operator!=(const program& x, const program& y) { return !(x == y); }
@@ -133,6 +138,12 @@ struct program
     std::unique_ptr<program_impl> impl;
 };
 
+/// Load a program that was saved before it was compiled
+program load(const std::string& filename);
+
+/// Load a program that was compiled for the target `t`, without compiling it again
+program load(const std::string& filename, const target& t);
+
 } // namespace MIGRAPHX_INLINE_NS
 } // namespace migraphx
 
@@ -0,0 +1,44 @@
+#ifndef MIGRAPHX_GUARD_RTGLIB_QUANTIZATION_HPP
+#define MIGRAPHX_GUARD_RTGLIB_QUANTIZATION_HPP
+
+#include <string>
+#include <vector>
+#include <migraphx/program.hpp>
+#include <migraphx/config.hpp>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+
+struct target;
+
+/// Run a copy of the program compiled for the target on each of the calibration inputs, and
+/// return the largest absolute value seen in each input of the instructions that
+/// `quantize_int8` rewrites, two for each instruction in program order. The target must keep
+/// its buffers in host memory, as the cpu target does.
+std::vector<float> capture_ranges(const program& prog,
+                                  const target& t,
+                                  const std::vector<program::parameter_map>& calibration,
+                                  const std::vector<std::string>& ins_names = {"dot",
+                                                                               "convolution"});
+
+/**
+ * Rewrite the float dot and convolution instructions named in `ins_names` to multiply int8
+ * values and accumulate the products in int32. Each input is quantized symmetrically with the
+ * scale `range / 127`, taken from the ranges returned by `capture_ranges`, and the result is
+ * converted back to float. The quantized weights become int8 literals when the program is
+ * compiled.
+ */
+void quantize_int8(program& prog,
+                   const std::vector<float>& ranges,
+                   const std::vector<std::string>& ins_names = {"dot", "convolution"});
+
+/// Calibrate the program on the target, and quantize it with the ranges that were captured
+void quantize_int8(program& prog,
+                   const target& t,
+                   const std::vector<program::parameter_map>& calibration,
+                   const std::vector<std::string>& ins_names = {"dot", "convolution"});
+
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
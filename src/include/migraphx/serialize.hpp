@@ -0,0 +1,230 @@
+#ifndef MIGRAPHX_GUARD_RTGLIB_SERIALIZE_HPP
+#define MIGRAPHX_GUARD_RTGLIB_SERIALIZE_HPP
+
+#include <migraphx/operation.hpp>
+#include <migraphx/shape.hpp>
+#include <migraphx/reflect.hpp>
+#include <migraphx/errors.hpp>
+#include <migraphx/rank.hpp>
+#include <migraphx/requires.hpp>
+#include <migraphx/functional.hpp>
+#include <migraphx/config.hpp>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+
+/// Writes values in the binary format used to save programs
+struct binary_writer
+{
+    std::ostream* os   = nullptr;
+    std::size_t offset = 0;
+
+    void write(const char* data, std::size_t n)
+    {
+        os->write(data, n);
+        offset += n;
+    }
+
+    /// Pad with zeros until the offset is a multiple of `alignment`
+    void align(std::size_t alignment)
+    {
+        static const std::array<char, 64> zeros{};
+        while(offset % alignment != 0)
+            write(zeros.data(), std::min(zeros.size(), alignment - offset % alignment));
+    }
+};
+
+/// Reads values in the binary format used to save programs from a buffer
+struct binary_reader
+{
+    const char* data   = nullptr;
+    std::size_t size   = 0;
+    std::size_t offset = 0;
+
+    const char* read(std::size_t n)
+    {
+        if(n > size - offset)
+            MIGRAPHX_THROW("Unexpected end of file");
+        const char* result = data + offset;
+        offset += n;
+        return result;
+    }
+
+    void align(std::size_t alignment)
+    {
+        std::size_t n = (alignment - offset % alignment) % alignment;
+        read(n);
+    }
+};
+
+template <class T>
+void serialize(binary_writer& w, const T& x);
+
+template <class T>
+void deserialize(binary_reader& r, T& x);
+
+void serialize(binary_writer& w, const operation& op);
+void deserialize(binary_reader& r, operation& op);
+
+namespace detail {
+
+inline void serialize_impl(rank<4>, binary_writer& w, const std::string& x)
+{
+    serialize(w, std::uint64_t{x.size()});
+    w.write(x.data(), x.size());
+}
+
+// A template so the enums are not converted to a shape
+template <class T, MIGRAPHX_REQUIRES(std::is_same<T, shape>{})>
+void serialize_impl(rank<4>, binary_writer& w, const T& x)
+{
+    serialize(w, x.type());
+    serialize(w, x.lens());
+    serialize(w, x.strides());
+}
+
+template <class T>
+void serialize_impl(rank<3>, binary_writer& w, const std::vector<T>& x)
+{
+    serialize(w, std::uint64_t{x.size()});
+    for(const auto& y : x)
+        serialize(w, y);
+}
+
+template <class T, std::size_t N>
+void serialize_impl(rank<3>, binary_writer& w, const std::array<T, N>& x)
+{
+    for(const auto& y : x)
+        serialize(w, y);
+}
+
+template <class T, MIGRAPHX_REQUIRES(std::is_arithmetic<T>{} or std::is_enum<T>{})>
+void serialize_impl(rank<2>, binary_writer& w, const T& x)
+{
+    w.write(reinterpret_cast<const char*>(&x), sizeof(T));
+}
+
+template <class T>
+void serialize_impl(rank<1>, binary_writer& w, const T& x)
+{
+    reflect_each(x, [&](const auto& y, auto&&) { serialize(w, y); });
+}
+
+inline void deserialize_impl(rank<4>, binary_reader& r, std::string& x)
+{
+    std::uint64_t n = 0;
+    deserialize(r, n);
+    const char* data = r.read(n);
+    x.assign(data, data + n);
+}
+
+inline void deserialize_impl(rank<4>, binary_reader& r, shape& x)
+{
+    shape::type_t t{};
+    std::vector<std::size_t> lens;
+    std::vector<std::size_t> strides;
+    deserialize(r, t);
+    deserialize(r, lens);
+    deserialize(r, strides);
+    if(lens.size() != strides.size())
+        MIGRAPHX_THROW("Invalid shape in file");
+    x = shape{t, lens, strides};
+}
+
+template <class T>
+void deserialize_impl(rank<3>, binary_reader& r, std::vector<T>& x)
+{
+    std::uint64_t n = 0;
+    deserialize(r, n);
+    // Each element takes at least a byte, so this avoids allocating a huge
+    // vector for a corrupted file
+    if(n > r.size - r.offset)
+        MIGRAPHX_THROW("Unexpected end of file");
+    x.resize(n);
+    for(auto& y : x)
+        deserialize(r, y);
+}
+
+template <class T, std::size_t N>
+void deserialize_impl(rank<3>, binary_reader& r, std::array<T, N>& x)
+{
+    for(auto& y : x)
+        deserialize(r, y);
+}
+
+template <class T, MIGRAPHX_REQUIRES(std::is_arithmetic<T>{} or std::is_enum<T>{})>
+void deserialize_impl(rank<2>, binary_reader& r, T& x)
+{
+    std::memcpy(&x, r.read(sizeof(T)), sizeof(T));
+}
+
+template <class T>
+void deserialize_impl(rank<1>, binary_reader& r, T& x)
+{
+    reflect_each(x, [&](auto& y, auto&&) { deserialize(r, y); });
+}
+
+} // namespace detail
+
+/// Write a value, where classes are written as the fields they reflect
+template <class T>
+void serialize(binary_writer& w, const T& x)
+{
+    detail::serialize_impl(rank<4>{}, w, x);
+}
+
+/// Read a value written by `serialize`
+template <class T>
+void deserialize(binary_reader& r, T& x)
+{
+    detail::deserialize_impl(rank<4>{}, r, x);
+}
+
+/// How to save and load one type of operator
+struct op_serializer
+{
+    std::function<void(binary_writer&, const operation&)> save;
+    std::function<operation(binary_reader&)> load;
+};
+
+/// Save and load an operator as the fields it reflects. The operator needs
+/// to be default constructible and reflect all of its fields.
+template <class T>
+op_serializer make_op_serializer()
+{
+    return {[](binary_writer& w, const operation& op) { serialize(w, any_cast<T>(op)); },
+            [](binary_reader& r) -> operation {
+                T x{};
+                deserialize(r, x);
+                return x;
+            }};
+}
+
+void register_op_serializer(const std::string& name, op_serializer s);
+
+/// Make an operator loadable from a saved program
+template <class T>
+void register_op()
+{
+    register_op_serializer(T{}.name(), make_op_serializer<T>());
+}
+
+template <class... Ts>
+bool register_ops()
+{
+    swallow{(register_op<Ts>(), 0)...};
+    return true;
+}
+
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
@@ -2,8 +2,11 @@
 #define MIGRAPHX_GUARD_MIGRAPHLIB_SHAPE_FOR_EACH_HPP
 
 #include <migraphx/shape.hpp>
+#include <migraphx/functional.hpp>
 #include <migraphx/config.hpp>
 #include <algorithm>
+#include <array>
+#include <numeric>
 
 namespace migraphx {
 inline namespace MIGRAPHX_INLINE_NS {
@@ -12,22 +15,154 @@ template <class F>
 void shape_for_each(const migraphx::shape& s, F f)
 {
     // Ensure calls to f use const ref to vector
-    auto call = [&f](const std::vector<std::size_t>& i) { f(i); };
-    std::vector<std::size_t> indices(s.lens().size());
-    for(std::size_t i = 0; i < s.elements(); i++)
+    auto call        = [&f](const std::vector<std::size_t>& i) { f(i); };
+    const auto& lens = s.lens();
+    // Visit the dimensions from the largest stride to the smallest so the
+    // elements are visited in the order they are stored
+    std::vector<std::size_t> order(lens.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t x, std::size_t y) {
+        return s.strides()[x] > s.strides()[y];
+    });
+    std::vector<std::size_t> indices(lens.size());
+    const std::size_t elements = s.elements();
+    for(std::size_t i = 0; i < elements; i++)
     {
-        std::transform(s.strides().begin(),
-                       s.strides().end(),
-                       s.lens().begin(),
-                       indices.begin(),
-                       [&](std::size_t stride, std::size_t len) {
-                           assert(len > 0 and stride > 0);
-                           return (i / stride) % len;
-                       });
         call(indices);
+        // Increment the indices like an odometer instead of dividing for
+        // every element
+        for(auto d = order.rbegin(); d != order.rend(); ++d)
+        {
+            if(++indices[*d] < lens[*d])
+                break;
+            indices[*d] = 0;
+        }
     }
 }
 
+/// Walks the element offsets of several shapes that have the same lens, in
+/// the standard order of the lens. The dimensions that are contiguous in
+/// every shape are merged, so the innermost loop is as long as possible.
+template <std::size_t N>
+struct offset_walker
+{
+    using offsets = std::array<std::size_t, N>;
+
+    std::vector<std::size_t> lens;
+    std::vector<offsets> strides;
+
+    explicit offset_walker(const std::array<shape, N>& shapes)
+    {
+        const auto& s_lens = shapes.front().lens();
+        // Build the dimensions from the innermost one
+        for(std::size_t d = s_lens.size(); d > 0; d--)
+        {
+            std::size_t len = s_lens[d - 1];
+            if(len == 1)
+                continue;
+            offsets dim_strides;
+            std::transform(shapes.begin(),
+                           shapes.end(),
+                           dim_strides.begin(),
+                           [&](const shape& s) { return s.strides()[d - 1]; });
+            if(not lens.empty() and contiguous(dim_strides))
+            {
+                lens.back() *= len;
+                continue;
+            }
+            lens.push_back(len);
+            strides.push_back(dim_strides);
+        }
+        if(lens.empty())
+        {
+            lens.push_back(1);
+            strides.push_back(offsets{});
+        }
+        std::reverse(lens.begin(), lens.end());
+        std::reverse(strides.begin(), strides.end());
+    }
+
+    std::size_t elements() const
+    {
+        return std::accumulate(
+            lens.begin(), lens.end(), std::size_t{1}, std::multiplies<std::size_t>{});
+    }
+
+    /// Call `f` with the offset in each shape for the elements in `[start, last)`
+    template <class F>
+    void operator()(std::size_t start, std::size_t last, F f) const
+    {
+        if(start >= last)
+            return;
+        const std::size_t n = lens.size();
+        std::vector<std::size_t> indices(n);
+        offsets base{};
+        // Only the starting index needs a division
+        std::size_t r = start;
+        for(std::size_t d = n; d > 0; d--)
+        {
+            indices[d - 1] = r % lens[d - 1];
+            r /= lens[d - 1];
+            for(std::size_t k = 0; k < N; k++)
+                base[k] += indices[d - 1] * strides[d - 1][k];
+        }
+        const auto& inner_strides = strides.back();
+        std::size_t i             = start;
+        for(;;)
+        {
+            std::size_t count = std::min(lens.back() - indices.back(), last - i);
+            offsets o         = base;
+            for(std::size_t j = 0; j < count; j++)
+            {
+                unpack(f, o);
+                for(std::size_t k = 0; k < N; k++)
+                    o[k] += inner_strides[k];
+            }
+            i += count;
+            if(i >= last)
+                return;
+            // Move to the start of the next row
+            for(std::size_t k = 0; k < N; k++)
+                base[k] -= indices.back() * inner_strides[k];
+            indices.back() = 0;
+            for(std::size_t d = n - 1; d > 0; d--)
+            {
+                for(std::size_t k = 0; k < N; k++)
+                    base[k] += strides[d - 1][k];
+                if(++indices[d - 1] < lens[d - 1])
+                    break;
+                for(std::size_t k = 0; k < N; k++)
+                    base[k] -= lens[d - 1] * strides[d - 1][k];
+                indices[d - 1] = 0;
+            }
+        }
+    }
+
+    private:
+    // Whether a dimension with these strides can be merged with the current
+    // outermost dimension
+    bool contiguous(const offsets& outer) const
+    {
+        for(std::size_t k = 0; k < N; k++)
+        {
+            if(outer[k] != strides.back()[k] * lens.back())
+                return false;
+        }
+        return true;
+    }
+};
+
+/// Call `f` with the element offset in each shape, for every index of the
+/// first shape
+template <class... Shapes>
+auto for_each_offset(const shape& s, const Shapes&... ss)
+{
+    return [=](auto f) {
+        offset_walker<sizeof...(Shapes) + 1> w{{{s, ss...}}};
+        w(0, w.elements(), f);
+    };
+}
+
 } // namespace MIGRAPHX_INLINE_NS
 } // namespace migraphx
 
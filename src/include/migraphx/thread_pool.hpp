@@ -0,0 +1,64 @@
+#ifndef MIGRAPHX_GUARD_RTGLIB_THREAD_POOL_HPP
+#define MIGRAPHX_GUARD_RTGLIB_THREAD_POOL_HPP
+
+#include <migraphx/config.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+
+/// A pool of persistent worker threads. The work is split into chunks which
+/// the workers, and the calling thread, grab dynamically until none are left.
+struct thread_pool
+{
+    using range_function = std::function<void(std::size_t, std::size_t)>;
+
+    /// Create a pool that runs work on `n` threads, counting the calling
+    /// thread, so `n - 1` workers are started. When `pin` is set each worker
+    /// is bound to its own core.
+    explicit thread_pool(std::size_t n, bool pin = false);
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+    ~thread_pool();
+
+    /// Number of threads that can run work, including the calling thread
+    std::size_t size() const;
+
+    /// Call `f(start, last)` for each chunk of `grainsize` elements in
+    /// `[0, n)` using at most `max_threads` threads. Runs serially on the
+    /// calling thread when the pool is already busy, such as for a nested
+    /// call from a worker.
+    void parallel_for(std::size_t n,
+                      std::size_t grainsize,
+                      std::size_t max_threads,
+                      const range_function& f);
+
+    private:
+    struct job;
+    void run_worker();
+
+    std::vector<std::thread> workers;
+    std::mutex submit_mutex;
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    job* current       = nullptr;
+    std::size_t active = 0;
+    std::size_t epoch  = 0;
+    bool stopping      = false;
+};
+
+/// The process-wide pool used by par_for. Its size defaults to the number of
+/// hardware threads and can be set with MIGRAPHX_NUM_THREADS, and setting
+/// MIGRAPHX_PIN_THREADS binds its workers to cores.
+thread_pool& get_thread_pool();
+
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
@@ -0,0 +1,33 @@
+#include <migraphx/mapped_file.hpp>
+#include <migraphx/errors.hpp>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+
+std::shared_ptr<char> map_file(const std::string& filename, std::size_t& size)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY); // NOLINT
+    if(fd < 0)
+        MIGRAPHX_THROW("Failed to open file: " + filename);
+    struct stat st
+    {
+    };
+    if(::fstat(fd, &st) != 0 or st.st_size == 0)
+    {
+        ::close(fd);
+        MIGRAPHX_THROW("Failed to read file: " + filename);
+    }
+    size      = st.st_size;
+    void* ptr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(ptr == MAP_FAILED) // NOLINT
+        MIGRAPHX_THROW("Failed to map file: " + filename);
+    return {static_cast<char*>(ptr), [size](char* p) { ::munmap(p, size); }};
+}
+
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
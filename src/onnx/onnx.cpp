@@ -2,7 +2,8 @@
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 #include <onnx.pb.h>
 #include <iostream>
-#include <fstream>
+#include <limits>
+#include <memory>
 #include <unordered_map>
 #include <functional>
 #include <array>
@@ -15,6 +16,7 @@
 #include <migraphx/ranges.hpp>
 #include <migraphx/instruction.hpp>
 #include <migraphx/config.hpp>
+#include <migraphx/mapped_file.hpp>
 #include <migraphx/onnx.hpp>
 
 namespace migraphx {
@@ -30,6 +32,9 @@ struct onnx_parser
     std::unordered_map<std::string, instruction_ref> instructions;
     program prog    = program();
     bool is_pytorch = false;
+    // Directory of the model, where the external data is found
+    std::string path;
+    std::unordered_map<std::string, std::pair<std::shared_ptr<char>, std::size_t>> external_files;
 
     std::unordered_map<std::string, op_func> ops;
     std::unordered_map<std::string, operation> map_actv_funcs;
@@ -40,6 +45,7 @@ struct onnx_parser
         add_generic_op("Sigmoid", op::sigmoid{});
         add_generic_op("Abs", op::abs{});
         add_generic_op("Exp", op::exp{});
+        add_generic_op("Erf", op::erf{});
         add_generic_op("Log", op::log{});
         // disable dropout for inference
         add_generic_op("Dropout", op::identity{});
@@ -1214,14 +1220,14 @@ struct onnx_parser
         return {hidden_states, last_output, last_cell_output};
     }
 
-    void parse_from(std::istream& is)
+    void parse_from(const char* data, std::size_t size)
     {
         onnx::ModelProto model;
-        if(model.ParseFromIstream(&is))
+        if(size <= std::numeric_limits<int>::max() and model.ParseFromArray(data, size))
         {
             if(model.has_graph())
             {
-                this->parse_graph(model.graph());
+                this->parse_graph(*model.mutable_graph());
             }
         }
         else
@@ -1230,13 +1236,13 @@ struct onnx_parser
         }
     }
 
-    void parse_graph(const onnx::GraphProto& graph)
+    void parse_graph(onnx::GraphProto& graph)
     {
         nodes = get_nodes(graph);
-        std::unordered_map<std::string, onnx::TensorProto> initializer_data;
-        for(auto&& f : graph.initializer())
+        std::unordered_map<std::string, onnx::TensorProto*> initializer_data;
+        for(auto&& f : *graph.mutable_initializer())
         {
-            initializer_data[f.name()] = f;
+            initializer_data[f.name()] = &f;
         }
         for(auto&& input : graph.input())
         {
@@ -1244,8 +1250,7 @@ struct onnx_parser
             // Does the input have an initializer?
             if(contains(initializer_data, name))
             {
-                auto t             = initializer_data[name];
-                instructions[name] = prog.add_literal(parse_tensor(t));
+                instructions[name] = prog.add_literal(parse_initializer(*initializer_data[name]));
             }
             else
             {
@@ -1375,6 +1380,100 @@ struct onnx_parser
         MIGRAPHX_THROW("Invalid attribute type");
     }
 
+    // Initializers can be large, so their data is used without a copy when
+    // possible: raw data is taken out of the message and external data is
+    // mapped from its file.
+    literal parse_initializer(onnx::TensorProto& t)
+    {
+        std::shared_ptr<char> data;
+        std::size_t size = 0;
+        if(t.data_location() == onnx::TensorProto::EXTERNAL)
+        {
+            data = get_external_data(t, size);
+        }
+        else if(t.has_raw_data())
+        {
+            std::shared_ptr<std::string> raw{t.release_raw_data()};
+            size = raw->size();
+            data = std::shared_ptr<char>(raw, &(*raw)[0]);
+        }
+        else
+        {
+            return parse_tensor(t);
+        }
+        shape::type_t type{};
+        if(not get_raw_type(t.data_type(), type))
+        {
+            // The data needs to be converted, so copy it back to the message
+            t.set_raw_data(data.get(), size);
+            return parse_tensor(t);
+        }
+        std::vector<std::size_t> dims(t.dims().begin(), t.dims().end());
+        shape s = dims.empty() ? shape{type} : shape{type, dims};
+        if(size < s.bytes())
+            MIGRAPHX_THROW("Not enough data for initializer: " + t.name());
+        // Unaligned data can't be accessed in place
+        if(reinterpret_cast<std::uintptr_t>(data.get()) % s.type_size() != 0)
+            return literal{s, data.get()};
+        return literal{s, std::move(data)};
+    }
+
+    std::shared_ptr<char> get_external_data(const onnx::TensorProto& t, std::size_t& size)
+    {
+        std::string location;
+        std::size_t offset = 0;
+        std::size_t length = 0;
+        bool has_length    = false;
+        for(auto&& entry : t.external_data())
+        {
+            if(entry.key() == "location")
+                location = entry.value();
+            else if(entry.key() == "offset")
+                offset = std::stoull(entry.value());
+            else if(entry.key() == "length")
+            {
+                length     = std::stoull(entry.value());
+                has_length = true;
+            }
+        }
+        if(location.empty())
+            MIGRAPHX_THROW("No location for the external data of " + t.name());
+        // The location is relative to the directory of the model, and a file
+        // is mapped once for all of the tensors stored in it
+        auto filename = path + location;
+        auto it       = external_files.find(filename);
+        if(it == external_files.end())
+        {
+            std::size_t file_size = 0;
+            auto file             = map_file(filename, file_size);
+            it = external_files.emplace(filename, std::make_pair(file, file_size)).first;
+        }
+        const std::size_t file_size = it->second.second;
+        if(offset > file_size)
+            MIGRAPHX_THROW("Invalid offset for the external data of " + t.name());
+        if(not has_length)
+            length = file_size - offset;
+        if(length > file_size - offset)
+            MIGRAPHX_THROW("Invalid length for the external data of " + t.name());
+        size = length;
+        return {it->second.first, it->second.first.get() + offset};
+    }
+
+    // The types whose data can be used as stored in the file
+    static bool get_raw_type(int dtype, shape::type_t& type)
+    {
+        switch(dtype)
+        {
+        case onnx::TensorProto::FLOAT: type = shape::float_type; return true;
+        case onnx::TensorProto::INT8: type = shape::int8_type; return true;
+        case onnx::TensorProto::INT32: type = shape::int32_type; return true;
+        case onnx::TensorProto::INT64: type = shape::int64_type; return true;
+        case onnx::TensorProto::FLOAT16: type = shape::half_type; return true;
+        case onnx::TensorProto::DOUBLE: type = shape::double_type; return true;
+        default: return false;
+        }
+    }
+
     static literal parse_tensor(const onnx::TensorProto& t)
     {
         std::vector<std::size_t> dims(t.dims().begin(), t.dims().end());
@@ -1386,7 +1485,7 @@ struct onnx_parser
             case onnx::TensorProto::UNDEFINED: throw std::runtime_error("");
             case onnx::TensorProto::FLOAT: return create_literal(shape::float_type, dims, s.data());
             case onnx::TensorProto::UINT8: throw std::runtime_error("");
-            case onnx::TensorProto::INT8: return create_literal(shape::int32_type, dims, s.data());
+            case onnx::TensorProto::INT8: return create_literal(shape::int8_type, dims, s.data());
             case onnx::TensorProto::UINT16:
                 return create_literal(shape::int32_type, dims, s.data());
             case onnx::TensorProto::INT16: return create_literal(shape::int32_type, dims, s.data());
@@ -1412,7 +1511,7 @@ struct onnx_parser
             return create_literal(shape::float_type, dims, t.float_data());
         case onnx::TensorProto::UINT8: throw std::runtime_error("");
         case onnx::TensorProto::INT8:
-            return create_literal(shape::int32_type, dims, t.int32_data());
+            return create_literal(shape::int8_type, dims, t.int32_data());
         case onnx::TensorProto::UINT16:
             return create_literal(shape::int32_type, dims, t.int32_data());
         case onnx::TensorProto::INT16:
@@ -1530,13 +1629,15 @@ struct onnx_parser
 
 program parse_onnx(const std::string& name)
 {
-    std::fstream input(name.c_str(), std::ios::in | std::ios::binary);
+    std::size_t size = 0;
+    auto buffer      = map_file(name, size);
     onnx_parser parser;
+    parser.path = name.substr(0, name.find_last_of('/') + 1);
 #ifndef NDEBUG
     // Log the program when it can't be parsed
     try
     {
-        parser.parse_from(input);
+        parser.parse_from(buffer.get(), size);
     }
     catch(...)
     {
@@ -1544,7 +1645,7 @@ program parse_onnx(const std::string& name)
         throw;
     }
 #else
-    parser.parse_from(input);
+    parser.parse_from(buffer.get(), size);
 #endif
     return std::move(parser.prog);
 }
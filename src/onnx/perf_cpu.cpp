@@ -0,0 +1,99 @@
+#include <migraphx/onnx.hpp>
+
+#include <migraphx/cpu/target.hpp>
+#include <migraphx/cpu/context.hpp>
+#include <migraphx/cpu/lowering.hpp>
+#include <migraphx/cpu/fuse_ops.hpp>
+#include <migraphx/cpu/preallocate_memory.hpp>
+#include <migraphx/auto_contiguous.hpp>
+#include <migraphx/dead_code_elimination.hpp>
+#include <migraphx/eliminate_allocation.hpp>
+#include <migraphx/memory_coloring.hpp>
+#include <migraphx/rewrite_rnn.hpp>
+#include <migraphx/generate.hpp>
+#include <migraphx/time.hpp>
+#include <iomanip>
+#include <iostream>
+
+// The cpu pipeline without the graph optimizations, to measure what they gain
+struct cpu_lowering_only
+{
+    std::string name() const { return "cpu"; }
+    std::vector<migraphx::pass> get_passes(migraphx::context& gctx) const
+    {
+        auto& ctx = migraphx::any_cast<migraphx::cpu::context>(gctx);
+        return {migraphx::rewrite_rnn{},
+                migraphx::dead_code_elimination{},
+                migraphx::auto_contiguous{},
+                migraphx::dead_code_elimination{},
+                migraphx::cpu::lowering{},
+                migraphx::dead_code_elimination{},
+                migraphx::cpu::fuse_ops{},
+                migraphx::dead_code_elimination{},
+                migraphx::memory_coloring{"cpu::allocate"},
+                migraphx::dead_code_elimination{},
+                migraphx::eliminate_allocation{"cpu::allocate"},
+                migraphx::cpu::preallocate_memory{&ctx},
+                migraphx::dead_code_elimination{}};
+    }
+    migraphx::context get_context() const { return migraphx::cpu::context{}; }
+};
+
+migraphx::program::parameter_map create_param_map(const migraphx::program& p)
+{
+    migraphx::program::parameter_map m;
+    for(auto&& x : p.get_parameter_shapes())
+        m[x.first] = migraphx::generate_argument(x.second);
+    return m;
+}
+
+// Average time of one run in milliseconds
+template <class Target>
+double run_time(const std::string& file, const Target& t, std::size_t n)
+{
+    auto p = migraphx::parse_onnx(file);
+    p.compile(t);
+    auto m = create_param_map(p);
+    // Warm up the caches and the thread pool
+    p.eval(m);
+    auto total = migraphx::time<std::chrono::duration<double, std::milli>>([&] {
+        for(std::size_t i = 0; i < n; i++)
+            p.eval(m);
+    });
+    return total / n;
+}
+
+// Compare the time of each model compiled with only the lowering and with
+// the full cpu pipeline:
+//
+//     perf_cpu [-n iterations] model.onnx...
+int main(int argc, char const* argv[])
+{
+    std::size_t n = 20;
+    std::vector<std::string> files;
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if(arg == "-n" and i + 1 < argc)
+            n = std::stoul(argv[++i]);
+        else
+            files.push_back(arg);
+    }
+    if(files.empty())
+    {
+        std::cout << "Usage: perf_cpu [-n iterations] model.onnx..." << std::endl;
+        return 1;
+    }
+    std::cout << std::left << std::setw(40) << "model" << std::right << std::setw(16)
+              << "lowering (ms)" << std::setw(16) << "optimized (ms)" << std::setw(10)
+              << "speedup" << std::endl;
+    for(auto&& file : files)
+    {
+        double baseline  = run_time(file, cpu_lowering_only{}, n);
+        double optimized = run_time(file, migraphx::cpu::target{}, n);
+        std::cout << std::left << std::setw(40) << file << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(16) << baseline << std::setw(16)
+                  << optimized << std::setw(9) << std::setprecision(2) << baseline / optimized
+                  << "x" << std::endl;
+    }
+}
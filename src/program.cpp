@@ -8,6 +8,9 @@
 #include <migraphx/time.hpp>
 #include <migraphx/iterator_for.hpp>
 #include <migraphx/pass_manager.hpp>
+#include <migraphx/serialize.hpp>
+#include <migraphx/mapped_file.hpp>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <algorithm>
@@ -16,11 +19,44 @@
 namespace migraphx {
 inline namespace MIGRAPHX_INLINE_NS {
 
+// One instruction of the execution plan, with its inputs resolved to the
+// indices of the steps that compute them
+struct eval_step
+{
+    enum step_kind
+    {
+        literal_step,
+        param_step,
+        outline_step,
+        compute_step
+    };
+
+    instruction_ref ins;
+    step_kind kind = compute_step;
+    std::vector<std::size_t> inputs;
+    std::string parameter;
+};
+
+// A flat representation of the program that can be evaluated without looking
+// up the instructions in a map
+struct eval_plan
+{
+    std::vector<eval_step> steps;
+    // The results of the literals, which are bound once
+    std::vector<argument> bound;
+
+    bool empty() const { return steps.empty(); }
+};
+
 struct program_impl
 {
     // A list is used to keep references to an instruction stable
     std::list<instruction> instructions;
     context ctx;
+    // The name of the target the program was compiled for
+    std::string target_name;
+    // Built by finalize, and cleared when the instructions change
+    eval_plan plan;
 };
 
 const operation& get_operation(instruction_ref ins) { return ins->get_operator(); }
@@ -83,6 +119,44 @@ static void print_program(const program& p, F print_func)
     }
 }
 
+static eval_plan make_plan(const program& p)
+{
+    eval_plan plan;
+    std::unordered_map<instruction_ref, std::size_t> slots;
+    plan.steps.reserve(p.size());
+    plan.bound.resize(p.size());
+    for(auto ins : iterator_for(p))
+    {
+        const std::size_t i = plan.steps.size();
+        eval_step step;
+        step.ins = ins;
+        if(ins->name() == "@literal")
+        {
+            step.kind     = eval_step::literal_step;
+            plan.bound[i] = ins->get_literal().get_argument();
+        }
+        else if(ins->name() == "@param")
+        {
+            step.kind      = eval_step::param_step;
+            step.parameter = any_cast<builtin::param>(ins->get_operator()).parameter;
+        }
+        else if(ins->name() == "@outline")
+        {
+            step.kind = eval_step::outline_step;
+        }
+        else
+        {
+            std::transform(ins->inputs().begin(),
+                           ins->inputs().end(),
+                           std::back_inserter(step.inputs),
+                           [&](instruction_ref x) { return slots.at(x); });
+        }
+        slots[ins] = i;
+        plan.steps.push_back(std::move(step));
+    }
+    return plan;
+}
+
 program::program() : impl(std::make_unique<program_impl>()) {}
 
 program::program(program&&) noexcept = default;
@@ -109,7 +183,9 @@ void program::assign(const program& p)
     {
         impl->instructions.clear();
     }
-    impl->ctx = p.impl->ctx;
+    impl->ctx         = p.impl->ctx;
+    impl->target_name = p.impl->target_name;
+    impl->plan        = {};
 
     std::unordered_map<instruction_ref, instruction_ref> ins_map;
     for(auto ins : iterator_for(p))
@@ -149,6 +225,8 @@ void program::assign(const program& p)
 
         ins_map[ins] = copy_ins;
     }
+    if(not p.impl->plan.empty())
+        impl->plan = make_plan(*this);
 }
 
 instruction_ref program::add_instruction(const operation& op, std::vector<instruction_ref> args)
@@ -165,6 +243,7 @@ instruction_ref program::insert_instruction(instruction_ref ins,
     assert(not starts_with(op.name(), "@"));
     shape r     = compute_shape(op, args);
     auto result = impl->instructions.insert(ins, {op, r, std::move(args)});
+    impl->plan  = {};
     instruction::backreference(result);
     assert(result->valid(begin()));
     return result;
@@ -181,6 +260,7 @@ instruction_ref program::replace_instruction(instruction_ref ins,
 
     shape r = compute_shape(op, args);
     instruction::replace(ins, op, r, std::move(args));
+    impl->plan = {};
     assert(ins->valid(begin()));
     return ins;
 }
@@ -201,6 +281,7 @@ instruction_ref program::replace_instruction(instruction_ref ins, instruction_re
     {
         return rep;
     }
+    impl->plan = {};
     // Make a copy of outputs which can be changed when calling replace_argument
     auto outputs = ins->outputs();
     for(auto out : outputs)
@@ -228,6 +309,7 @@ instruction_ref program::remove_instruction(instruction_ref ins)
     assert(has_instruction(ins));
     assert(ins->outputs().empty());
     ins->clear_arguments();
+    impl->plan = {};
     return impl->instructions.erase(ins);
 }
 
@@ -239,24 +321,28 @@ instruction_ref program::remove_instructions(instruction_ref first, instruction_
     assert(has_instruction(first));
     std::for_each(first, last, [&](instruction& ins) { ins.clear_arguments(); });
     assert(std::all_of(first, last, [&](instruction& ins) { return ins.outputs().empty(); }));
+    impl->plan = {};
     return impl->instructions.erase(first, last);
 }
 
 instruction_ref program::move_instruction(instruction_ref src, instruction_ref dst)
 {
     impl->instructions.splice(dst, impl->instructions, src);
+    impl->plan = {};
     return src;
 }
 
 instruction_ref program::add_literal(literal l)
 {
     impl->instructions.emplace_front(std::move(l));
+    impl->plan = {};
     return impl->instructions.begin();
 }
 
 instruction_ref program::add_outline(const shape& s)
 {
     impl->instructions.push_front({builtin::outline{s}, s, {}});
+    impl->plan = {};
     return impl->instructions.begin();
 }
 
@@ -264,6 +350,7 @@ instruction_ref program::add_parameter(std::string name, shape s)
 {
     assert(get_parameter_shape(name) == shape{});
     impl->instructions.push_front({builtin::param{std::move(name)}, std::move(s), {}});
+    impl->plan = {};
     return impl->instructions.begin();
 }
 
@@ -345,7 +432,8 @@ instruction_ref program::validate() const
 void program::compile(const target& t, tracer trace)
 {
     assert(this->validate() == impl->instructions.end());
-    this->impl->ctx = t.get_context();
+    this->impl->ctx         = t.get_context();
+    this->impl->target_name = t.name();
     if(enabled(MIGRAPHX_TRACE_COMPILE{}))
         trace = tracer{std::cout};
     trace(*this);
@@ -366,63 +454,74 @@ void program::finalize()
     {
         ins->finalize(this->impl->ctx);
     }
+    this->impl->plan = make_plan(*this);
+}
+
+// Use the plan built by finalize, or build one for a program that was not finalized
+static const eval_plan& get_plan(const program& p, const eval_plan& plan, eval_plan& tmp)
+{
+    if(not plan.empty() or p.size() == 0)
+        return plan;
+    tmp = make_plan(p);
+    return tmp;
 }
 
 template <class F>
 argument generic_eval(const program& p,
+                      const eval_plan& plan,
                       context& ctx,
                       std::unordered_map<std::string, argument> params,
                       F trace)
 {
     assert(p.validate() == p.end());
-    std::unordered_map<instruction_ref, argument> results;
-    results.reserve(p.size() * 2);
+    (void)p;
+    std::vector<argument> results = plan.bound;
     std::vector<argument> values;
     values.reserve(16);
-    for(auto ins : iterator_for(p))
+    for(std::size_t i = 0; i < plan.steps.size(); i++)
     {
-        if(ins->name() == "@literal")
-        {
-            results.emplace(ins, trace(ins, [&] { return ins->get_literal().get_argument(); }));
-        }
-        else if(ins->name() == "@param")
-        {
-            results.emplace(
-                ins, trace(ins, [&] {
-                    auto param_name = any_cast<builtin::param>(ins->get_operator()).parameter;
-                    if(not contains(params, param_name))
-                        MIGRAPHX_THROW("Parameter not found: " + param_name);
-                    auto param = params.at(param_name);
-                    if(param.get_shape() != ins->get_shape())
-                        MIGRAPHX_THROW("Incorrect shape {" + to_string(param.get_shape()) +
-                                       "} for parameter: " + param_name);
-                    return param;
-                }));
-        }
-        else if(ins->name() == "@outline")
-        {
-            results.emplace(ins, trace(ins, [&] { return argument{ins->get_shape(), nullptr}; }));
-        }
-        else
+        const auto& step = plan.steps[i];
+        auto ins         = step.ins;
+        switch(step.kind)
         {
-            values.resize(ins->inputs().size());
-            std::transform(
-                ins->inputs().begin(), ins->inputs().end(), values.begin(), [&](instruction_ref i) {
-                    assert(results.find(i) != results.end());
-                    return results[i];
-                });
-            results.emplace(ins, trace(ins, [&] {
-                                return ins->get_operator().compute(ctx, ins->get_shape(), values);
-                            }));
+        case eval_step::literal_step:
+            results[i] = trace(ins, [&] { return results[i]; });
+            break;
+        case eval_step::param_step:
+            results[i] = trace(ins, [&] {
+                auto param = params.find(step.parameter);
+                if(param == params.end())
+                    MIGRAPHX_THROW("Parameter not found: " + step.parameter);
+                if(param->second.get_shape() != ins->get_shape())
+                    MIGRAPHX_THROW("Incorrect shape {" + to_string(param->second.get_shape()) +
+                                   "} for parameter: " + step.parameter);
+                return param->second;
+            });
+            break;
+        case eval_step::outline_step:
+            results[i] = trace(ins, [&] { return argument{ins->get_shape(), nullptr}; });
+            break;
+        case eval_step::compute_step:
+            values.resize(step.inputs.size());
+            std::transform(step.inputs.begin(),
+                           step.inputs.end(),
+                           values.begin(),
+                           [&](std::size_t j) { return results[j]; });
+            results[i] = trace(
+                ins, [&] { return ins->get_operator().compute(ctx, ins->get_shape(), values); });
+            break;
         }
-        assert(results.find(ins) != results.end());
     }
-    return results.at(std::prev(p.end()));
+    if(results.empty())
+        return {};
+    return results.back();
 }
 
 argument program::eval(std::unordered_map<std::string, argument> params) const
 {
     auto& ctx = this->impl->ctx;
+    eval_plan tmp;
+    const auto& plan = get_plan(*this, impl->plan, tmp);
 #ifndef NDEBUG
     auto sctx          = ctx;
     auto check_context = [&](auto f) {
@@ -436,7 +535,7 @@ argument program::eval(std::unordered_map<std::string, argument> params) const
 #endif
     if(enabled(MIGRAPHX_TRACE_EVAL{}))
     {
-        return generic_eval(*this, ctx, std::move(params), [&](auto& ins, auto f) {
+        return generic_eval(*this, plan, ctx, std::move(params), [&](auto& ins, auto f) {
             ctx.finish();
             std::cout << "Run instruction: ";
             this->debug_print(ins);
@@ -445,8 +544,9 @@ argument program::eval(std::unordered_map<std::string, argument> params) const
     }
     else
     {
-        return generic_eval(
-            *this, ctx, std::move(params), [&](auto&, auto f) { return check_context(f); });
+        return generic_eval(*this, plan, ctx, std::move(params), [&](auto&, auto f) {
+            return check_context(f);
+        });
     }
 }
 
@@ -476,15 +576,17 @@ void program::perf_report(std::ostream& os, std::size_t n, parameter_map params)
     }
     std::sort(total_vec.begin(), total_vec.end());
     std::unordered_map<instruction_ref, std::vector<double>> ins_vec;
+    eval_plan tmp;
+    const auto& plan = get_plan(*this, impl->plan, tmp);
     // Fill the map
-    generic_eval(*this, ctx, params, [&](auto ins, auto) {
+    generic_eval(*this, plan, ctx, params, [&](auto ins, auto) {
         ins_vec[ins].reserve(n);
         return argument{};
     });
     // Run and time each instruction
     for(std::size_t i = 0; i < n; i++)
     {
-        generic_eval(*this, ctx, params, [&](auto ins, auto f) {
+        generic_eval(*this, plan, ctx, params, [&](auto ins, auto f) {
             argument result;
             ins_vec[ins].push_back(time<milliseconds>([&] {
                 result = f();
@@ -605,7 +707,12 @@ void program::print_graph(std::ostream& os) const
 void program::dry_run(std::unordered_map<std::string, argument> params) const
 {
     auto& ctx = this->impl->ctx;
-    generic_eval(*this, ctx, std::move(params), [](auto&&...) { return argument{}; });
+    eval_plan tmp;
+    generic_eval(*this,
+                 get_plan(*this, impl->plan, tmp),
+                 ctx,
+                 std::move(params),
+                 [](auto&&...) { return argument{}; });
 }
 
 void program::annotate(std::ostream& os, std::function<void(instruction_ref)> a) const
@@ -617,6 +724,168 @@ void program::annotate(std::ostream& os, std::function<void(instruction_ref)> a)
     });
 }
 
+// The file starts with the magic string and the version of the format, so
+// files from an incompatible version are rejected
+static const std::string& program_file_magic()
+{
+    static const std::string magic = "MIGRAPHX";
+    return magic;
+}
+const std::uint32_t program_file_version = 1;
+// Literals are aligned so they can be used directly from the mapped file
+const std::size_t literal_alignment = 64;
+
+static std::size_t align_offset(std::size_t n)
+{
+    return (n + literal_alignment - 1) / literal_alignment * literal_alignment;
+}
+
+void program::save(const std::string& filename) const
+{
+    // Write the instructions first to know where the literals start
+    std::ostringstream graph;
+    binary_writer gw{&graph};
+    std::unordered_map<instruction_ref, std::uint64_t> index;
+    std::vector<instruction_ref> literals;
+    std::uint64_t data_size = 0;
+    serialize(gw, std::uint64_t{this->size()});
+    for(auto ins : iterator_for(*this))
+    {
+        serialize(gw, ins->get_operator());
+        serialize(gw, ins->get_shape());
+        std::vector<std::uint64_t> inputs;
+        std::transform(ins->inputs().begin(),
+                       ins->inputs().end(),
+                       std::back_inserter(inputs),
+                       [&](auto i) { return index.at(i); });
+        serialize(gw, inputs);
+        if(ins->name() == "@literal")
+        {
+            serialize(gw, data_size);
+            data_size = align_offset(data_size + ins->get_literal().get_shape().bytes());
+            literals.push_back(ins);
+        }
+        auto i     = index.size();
+        index[ins] = i;
+    }
+
+    std::ofstream os(filename, std::ios::binary);
+    if(not os)
+        MIGRAPHX_THROW("Failed to open file: " + filename);
+    binary_writer w{&os};
+    w.write(program_file_magic().data(), program_file_magic().size());
+    serialize(w, program_file_version);
+    serialize(w, impl->target_name);
+    auto g = graph.str();
+    // Offset of the literals in the file
+    serialize(w, std::uint64_t{align_offset(w.offset + sizeof(std::uint64_t) + g.size())});
+    w.write(g.data(), g.size());
+    w.align(literal_alignment);
+    for(auto ins : literals)
+    {
+        const auto& l = ins->get_literal();
+        w.write(l.data(), l.get_shape().bytes());
+        w.align(literal_alignment);
+    }
+    if(not os)
+        MIGRAPHX_THROW("Failed to write file: " + filename);
+}
+
+static program load_program(const std::string& filename, std::string& target_name)
+{
+    std::size_t size = 0;
+    auto buffer      = map_file(filename, size);
+    binary_reader r{buffer.get(), size};
+    const auto& magic = program_file_magic();
+    if(std::string(r.read(magic.size()), magic.size()) != magic)
+        MIGRAPHX_THROW("Not a program file: " + filename);
+    std::uint32_t version = 0;
+    deserialize(r, version);
+    if(version != program_file_version)
+        MIGRAPHX_THROW("Unsupported program file version: " + std::to_string(version));
+    deserialize(r, target_name);
+    std::uint64_t data_start = 0;
+    deserialize(r, data_start);
+    if(data_start > size)
+        MIGRAPHX_THROW("Invalid program file: " + filename);
+
+    program p;
+    std::vector<instruction_ref> instructions;
+    std::uint64_t n = 0;
+    deserialize(r, n);
+    for(std::uint64_t i = 0; i < n; i++)
+    {
+        operation op;
+        shape s;
+        std::vector<std::uint64_t> input_index;
+        deserialize(r, op);
+        deserialize(r, s);
+        deserialize(r, input_index);
+        std::vector<instruction_ref> inputs;
+        for(auto j : input_index)
+        {
+            if(j >= instructions.size())
+                MIGRAPHX_THROW("Invalid instruction input in file");
+            inputs.push_back(instructions[j]);
+        }
+        instruction_ref ins;
+        auto name = op.name();
+        // The builtins are added to the front of the program, so they are
+        // moved to the end to keep the same order
+        if(name == "@literal")
+        {
+            std::uint64_t offset = 0;
+            deserialize(r, offset);
+            if(offset > size - data_start or s.bytes() > size - data_start - offset)
+                MIGRAPHX_THROW("Literal data out of range in file");
+            // Share the mapping so the literal does not copy the data
+            std::shared_ptr<char> data{buffer, buffer.get() + data_start + offset};
+            ins = p.add_literal(literal{s, data});
+            p.move_instruction(ins, p.end());
+        }
+        else if(name == "@param")
+        {
+            ins = p.add_parameter(any_cast<builtin::param>(op).parameter, s);
+            p.move_instruction(ins, p.end());
+        }
+        else if(name == "@outline")
+        {
+            ins = p.add_outline(s);
+            p.move_instruction(ins, p.end());
+        }
+        else
+        {
+            ins = p.add_instruction(op, inputs);
+            if(ins->get_shape() != s)
+                MIGRAPHX_THROW("Shape mismatch for " + name + " in file");
+        }
+        instructions.push_back(ins);
+    }
+    return p;
+}
+
+program load(const std::string& filename)
+{
+    std::string target_name;
+    auto p = load_program(filename, target_name);
+    if(not target_name.empty())
+        MIGRAPHX_THROW("Program was compiled for target: " + target_name);
+    return p;
+}
+
+program load(const std::string& filename, const target& t)
+{
+    std::string target_name;
+    auto p = load_program(filename, target_name);
+    if(target_name != t.name())
+        MIGRAPHX_THROW("Program was compiled for target '" + target_name + "' instead of '" +
+                       t.name() + "'");
+    p.impl->ctx         = t.get_context();
+    p.impl->target_name = t.name();
+    p.finalize();
+    return p;
+}
+
 bool operator==(const program& x, const program& y) { return to_string(x) == to_string(y); }
 
 std::ostream& operator<<(std::ostream& os, const program& p)
@@ -3,6 +3,11 @@
 #include <migraphx/matcher.hpp>
 #include <migraphx/literal.hpp>
 #include <migraphx/functional.hpp>
+#include <migraphx/iterator_for.hpp>
+#include <migraphx/instruction.hpp>
+#include <migraphx/ranges.hpp>
+#include <migraphx/par_for.hpp>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace migraphx {
@@ -22,31 +27,100 @@ bool skip_propogate(instruction_ref ins)
 
 void propagate_constant::apply(program& p) const
 {
-    for(auto i : iterator_for(p))
+    // Instructions that can be computed from the literals
+    std::unordered_set<instruction_ref> constants;
+    for(auto ins : iterator_for(p))
     {
-        if(i->name() != "@literal")
+        if(ins->name() == "@literal" or
+           (not ins->inputs().empty() and is_context_free(ins->get_operator()) and
+            all_of(ins->inputs(), [&](auto input) { return constants.count(input) > 0; })))
+            constants.insert(ins);
+    }
+    auto folded = [&](instruction_ref ins) {
+        return constants.count(ins) > 0 and not skip_propogate(ins);
+    };
+
+    // Only the constants still used by an instruction that is not folded
+    // need a literal, and only their inputs need to be computed
+    std::unordered_set<instruction_ref> replaced;
+    std::unordered_map<instruction_ref, std::size_t> uses;
+    for(auto ins : reverse_iterator_for(p))
+    {
+        if(constants.count(ins) == 0 or ins->name() == "@literal")
+            continue;
+        if(folded(ins) and (ins->outputs().empty() or
+                            any_of(ins->outputs(), [&](auto output) { return not folded(output); })))
+            replaced.insert(ins);
+        else if(none_of(ins->outputs(), [&](auto output) { return uses.count(output) > 0; }))
             continue;
-        if(i->outputs().empty())
+        uses.insert({ins, 0});
+        for(auto input : ins->inputs())
+        {
+            if(input->name() != "@literal")
+                uses[input]++;
+        }
+    }
+
+    // Group the instructions by depth, so each group only depends on the
+    // previous ones and can be computed in parallel
+    std::unordered_map<instruction_ref, std::size_t> depth;
+    std::vector<std::vector<instruction_ref>> levels;
+    for(auto ins : iterator_for(p))
+    {
+        if(uses.count(ins) == 0)
             continue;
-        fix([&](auto self, auto ins) {
-            std::unordered_set<instruction_ref> children(ins->outputs().begin(),
-                                                         ins->outputs().end());
-            for(auto child : children)
+        std::size_t d = 0;
+        for(auto input : ins->inputs())
+        {
+            if(contains(depth, input))
+                d = std::max(d, depth[input] + 1);
+        }
+        depth[ins] = d;
+        if(levels.size() <= d)
+            levels.resize(d + 1);
+        levels[d].push_back(ins);
+    }
+
+    std::unordered_map<instruction_ref, argument> results;
+    for(auto&& level : levels)
+    {
+        std::vector<argument> level_results(level.size());
+        par_for(level.size(), 1, [&](std::size_t i) {
+            auto ins = level[i];
+            std::vector<argument> args;
+            std::transform(ins->inputs().begin(),
+                           ins->inputs().end(),
+                           std::back_inserter(args),
+                           [&](auto input) {
+                               if(input->name() == "@literal")
+                                   return input->get_literal().get_argument();
+                               return results.at(input);
+                           });
+            level_results[i] = ins->get_operator().compute(ins->get_shape(), args);
+        });
+        for(std::size_t i = 0; i < level.size(); i++)
+            results[level[i]] = std::move(level_results[i]);
+        // Release the intermediate results once they are not used anymore
+        for(auto ins : level)
+        {
+            for(auto input : ins->inputs())
             {
-                if(skip_propogate(child))
-                {
-                    self(child);
+                if(input->name() == "@literal")
                     continue;
-                }
-                auto r = child->eval();
-                if(not r.empty())
-                {
-                    assert(r.get_shape() == child->get_shape());
-                    auto l = p.add_literal(r.get_shape(), r.data());
-                    self(p.replace_instruction(child, l));
-                }
+                if(--uses[input] == 0 and replaced.count(input) == 0)
+                    results.erase(input);
             }
-        })(i);
+        }
+    }
+
+    for(auto ins : iterator_for(p))
+    {
+        if(replaced.count(ins) == 0)
+            continue;
+        const auto& r = results.at(ins);
+        assert(r.get_shape() == ins->get_shape());
+        // The literal takes the result without copying it
+        p.replace_instruction(ins, p.add_literal(literal{r}));
     }
 }
 
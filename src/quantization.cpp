@@ -0,0 +1,126 @@
+#include <migraphx/quantization.hpp>
+#include <migraphx/program.hpp>
+#include <migraphx/instruction.hpp>
+#include <migraphx/iterator_for.hpp>
+#include <migraphx/operators.hpp>
+#include <migraphx/ranges.hpp>
+#include <migraphx/target.hpp>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+
+// Only the multiplication of two float tensors is quantized. The third
+// input of a dot is added after the result is converted back to float.
+static bool is_quantizable(instruction_ref ins, const std::vector<std::string>& ins_names)
+{
+    if(not contains(ins_names, ins->name()))
+        return false;
+    if(ins->name() != "dot" and ins->name() != "convolution")
+        return false;
+    auto&& inputs = ins->inputs();
+    return inputs.size() >= 2 and inputs[0]->get_shape().type() == shape::float_type and
+           inputs[1]->get_shape().type() == shape::float_type;
+}
+
+std::vector<float> capture_ranges(const program& prog,
+                                  const target& t,
+                                  const std::vector<program::parameter_map>& calibration,
+                                  const std::vector<std::string>& ins_names)
+{
+    program p   = prog;
+    auto ranges = std::make_shared<std::vector<float>>();
+    auto record = [=](std::size_t i, const std::vector<argument>& args) {
+        float m = 0.0f;
+        args.front().visit([&](auto x) {
+            for(auto v : x)
+                m = std::max(m, std::abs(float(v)));
+        });
+        (*ranges)[i] = std::max((*ranges)[i], m);
+    };
+
+    std::size_t n = 0;
+    for(auto ins : iterator_for(p))
+    {
+        if(not is_quantizable(ins, ins_names))
+            continue;
+        auto inputs = ins->inputs();
+        for(std::size_t i = 0; i < 2; i++)
+            inputs[i] = p.insert_instruction(ins, op::capture{n++, record}, inputs[i]);
+        p.replace_instruction(ins, ins->get_operator(), inputs);
+    }
+    ranges->resize(n, 0.0f);
+
+    // The captures of constant inputs are computed when the program is compiled
+    p.compile(t);
+    for(auto&& params : calibration)
+        p.eval(params);
+    return *ranges;
+}
+
+void quantize_int8(program& prog,
+                   const std::vector<float>& ranges,
+                   const std::vector<std::string>& ins_names)
+{
+    std::size_t n   = 0;
+    auto next_scale = [&] {
+        if(n >= ranges.size())
+            MIGRAPHX_THROW("QUANTIZE_INT8: not enough ranges for the instructions");
+        float r = ranges[n++];
+        return r > 0.0f ? r / 127.0f : 1.0f;
+    };
+
+    for(auto ins : iterator_for(prog))
+    {
+        if(not is_quantizable(ins, ins_names))
+            continue;
+        auto inputs = ins->inputs();
+        float scale = 1.0f;
+        for(std::size_t i = 0; i < 2; i++)
+        {
+            float s = next_scale();
+            scale *= s;
+            inputs[i] = prog.insert_instruction(ins, op::quantizelinear{s}, inputs[i]);
+        }
+
+        if(ins->name() == "convolution")
+        {
+            auto&& conv = any_cast<op::convolution>(ins->get_operator());
+            op::quant_convolution qconv{
+                conv.padding, conv.stride, conv.dilation, conv.padding_mode, conv.group};
+            auto q = prog.insert_instruction(ins, qconv, inputs[0], inputs[1]);
+            prog.replace_instruction(ins, op::dequantizelinear{scale}, q);
+            continue;
+        }
+
+        auto&& dot = any_cast<op::dot>(ins->get_operator());
+        auto q     = prog.insert_instruction(ins, op::quant_dot{}, inputs[0], inputs[1]);
+        if(inputs.size() < 3 or dot.beta == 0.0f)
+        {
+            prog.replace_instruction(ins, op::dequantizelinear{dot.alpha * scale}, q);
+            continue;
+        }
+        auto ab = prog.insert_instruction(ins, op::dequantizelinear{dot.alpha * scale}, q);
+        auto c  = inputs[2];
+        if(dot.beta != 1.0f)
+        {
+            auto beta = prog.add_literal(literal{shape{shape::float_type}, {dot.beta}});
+            auto l = prog.insert_instruction(ins, op::multibroadcast{c->get_shape().lens()}, beta);
+            c = prog.insert_instruction(ins, op::mul{}, c, l);
+        }
+        prog.replace_instruction(ins, op::add{}, ab, c);
+    }
+}
+
+void quantize_int8(program& prog,
+                   const target& t,
+                   const std::vector<program::parameter_map>& calibration,
+                   const std::vector<std::string>& ins_names)
+{
+    quantize_int8(prog, capture_ranges(prog, t, calibration, ins_names), ins_names);
+}
+
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
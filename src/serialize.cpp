@@ -0,0 +1,118 @@
+#include <migraphx/serialize.hpp>
+#include <migraphx/operators.hpp>
+#include <migraphx/builtin.hpp>
+#include <unordered_map>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+
+static void register_builtin_ops(std::unordered_map<std::string, op_serializer>& m);
+
+static std::unordered_map<std::string, op_serializer>& op_serializers()
+{
+    static std::unordered_map<std::string, op_serializer> m = [] {
+        std::unordered_map<std::string, op_serializer> result;
+        register_builtin_ops(result);
+        return result;
+    }();
+    return m;
+}
+
+void register_op_serializer(const std::string& name, op_serializer s)
+{
+    op_serializers()[name] = std::move(s);
+}
+
+void serialize(binary_writer& w, const operation& op)
+{
+    auto name = op.name();
+    auto it   = op_serializers().find(name);
+    if(it == op_serializers().end())
+        MIGRAPHX_THROW("Operator can not be saved: " + name);
+    serialize(w, name);
+    it->second.save(w, op);
+}
+
+void deserialize(binary_reader& r, operation& op)
+{
+    std::string name;
+    deserialize(r, name);
+    auto it = op_serializers().find(name);
+    if(it == op_serializers().end())
+        MIGRAPHX_THROW("Unknown operator: " + name);
+    op = it->second.load(r);
+}
+
+template <class... Ts>
+static void add_ops(std::unordered_map<std::string, op_serializer>& m)
+{
+    swallow{(m[Ts{}.name()] = make_op_serializer<Ts>(), 0)...};
+}
+
+static void register_builtin_ops(std::unordered_map<std::string, op_serializer>& m)
+{
+    add_ops<builtin::literal, builtin::outline, builtin::param>(m);
+    add_ops<op::abs,
+            op::acos,
+            op::add,
+            op::as_shape,
+            op::asin,
+            op::atan,
+            op::batch_norm_inference,
+            op::broadcast,
+            op::clip,
+            op::concat,
+            op::contiguous,
+            op::convolution,
+            op::cos,
+            op::cosh,
+            op::dequantizelinear,
+            op::div,
+            op::dot,
+            op::elu,
+            op::erf,
+            op::exp,
+            op::flatten,
+            op::gather,
+            op::gru,
+            op::identity,
+            op::im2col,
+            op::leaky_relu,
+            op::load,
+            op::log,
+            op::logsoftmax,
+            op::lrn,
+            op::lstm,
+            op::lstm_last_cell_output,
+            op::max,
+            op::min,
+            op::mul,
+            op::multibroadcast,
+            op::neg,
+            op::outline,
+            op::pad,
+            op::pooling,
+            op::quant_convolution,
+            op::quant_dot,
+            op::quantizelinear,
+            op::relu,
+            op::reshape,
+            op::rnn,
+            op::rnn_last_output,
+            op::scalar,
+            op::sigmoid,
+            op::sin,
+            op::sinh,
+            op::slice,
+            op::softmax,
+            op::squeeze,
+            op::sub,
+            op::tan,
+            op::tanh,
+            op::transpose,
+            op::undefined,
+            op::unsqueeze>(m);
+}
+
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
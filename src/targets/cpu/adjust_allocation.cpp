@@ -0,0 +1,32 @@
+#include <migraphx/cpu/adjust_allocation.hpp>
+#include <migraphx/cpu/allocate.hpp>
+#include <migraphx/instruction.hpp>
+#include <migraphx/program.hpp>
+#include <migraphx/iterator_for.hpp>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+void adjust_allocation::apply(program& p) const
+{
+    for(auto ins : iterator_for(p))
+    {
+        if(ins->inputs().empty())
+            continue;
+
+        if(ins->name() == "load")
+            continue;
+
+        auto alias_ins = instruction::get_output_alias(ins, true);
+        if(alias_ins->name() == "cpu::allocate" and alias_ins->get_shape() != ins->get_shape())
+        {
+            auto alloc_ins = p.insert_instruction(ins, allocate{ins->get_shape()});
+            p.replace_instruction(alias_ins, alloc_ins);
+        }
+    }
+}
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
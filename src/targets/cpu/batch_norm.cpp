@@ -0,0 +1,108 @@
+#include <migraphx/cpu/batch_norm.hpp>
+#include <migraphx/cpu/vectorize.hpp>
+#include <migraphx/par_for.hpp>
+#include <migraphx/par_dfor.hpp>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+template <class T>
+MIGRAPHX_CPU_INLINE void scale_shift_plane(const T* x, T* y, std::size_t n, T scale, T shift)
+{
+    for(std::size_t i = 0; i < n; i++)
+        y[i] = x[i] * scale + shift;
+}
+
+template <class T>
+MIGRAPHX_CPU_INLINE void
+scale_shift_vector(const T* x, T* y, std::size_t n, const T* scale, const T* shift)
+{
+    for(std::size_t i = 0; i < n; i++)
+        y[i] = x[i] * scale[i] + shift[i];
+}
+
+template <class T>
+static void plane_kernel(const T* x, T* y, std::size_t n, T scale, T shift)
+{
+    scale_shift_plane(x, y, n, scale, shift);
+}
+
+MIGRAPHX_CPU_TARGETS
+static void plane_kernel(const float* x, float* y, std::size_t n, float scale, float shift)
+{
+    scale_shift_plane(x, y, n, scale, shift);
+}
+
+template <class T>
+static void vector_kernel(const T* x, T* y, std::size_t n, const T* scale, const T* shift)
+{
+    scale_shift_vector(x, y, n, scale, shift);
+}
+
+MIGRAPHX_CPU_TARGETS
+static void
+vector_kernel(const float* x, float* y, std::size_t n, const float* scale, const float* shift)
+{
+    scale_shift_vector(x, y, n, scale, shift);
+}
+
+// Whether the channels of each pixel are next to each other in memory
+static bool channels_last(const shape& s)
+{
+    const auto& lens = s.lens();
+    return s == shape{s.type(),
+                      lens,
+                      {lens[1] * lens[2] * lens[3], 1, lens[1] * lens[3], lens[1]}};
+}
+
+void scale_shift(const argument& result,
+                 const argument& input,
+                 const argument& scale,
+                 const argument& shift)
+{
+    visit_all(result, input, scale, shift)([&](auto output, auto x, auto s, auto t) {
+        const auto& xs         = x.get_shape();
+        const auto& lens       = output.get_shape().lens();
+        const std::size_t n    = lens[0];
+        const std::size_t c    = lens[1];
+        const std::size_t hw   = lens[2] * lens[3];
+        const bool per_channel = s.get_shape().elements() == c;
+        const bool same_layout = xs == output.get_shape();
+        if(same_layout and xs.standard() and per_channel)
+        {
+            par_for(n * c, 1, [&](std::size_t i) {
+                plane_kernel(
+                    x.data() + i * hw, output.data() + i * hw, hw, s[i % c], t[i % c]);
+            });
+        }
+        else if(same_layout and xs.standard())
+        {
+            par_for(n, 1, [&](std::size_t i) {
+                vector_kernel(x.data() + i * c * hw,
+                              output.data() + i * c * hw,
+                              c * hw,
+                              s.data(),
+                              t.data());
+            });
+        }
+        else if(same_layout and channels_last(xs) and per_channel)
+        {
+            par_for(n * hw, [&](std::size_t i) {
+                vector_kernel(x.data() + i * c, output.data() + i * c, c, s.data(), t.data());
+            });
+        }
+        else
+        {
+            par_dfor(n, c, lens[2], lens[3])(
+                [&](std::size_t b, std::size_t ch, std::size_t h, std::size_t w) {
+                    std::size_t k       = per_channel ? ch : (ch * lens[2] + h) * lens[3] + w;
+                    output(b, ch, h, w) = x(b, ch, h, w) * s[k] + t[k];
+                });
+        }
+    });
+}
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
@@ -0,0 +1,116 @@
+#include <migraphx/cpu/convert.hpp>
+#include <migraphx/errors.hpp>
+#include <migraphx/par_for.hpp>
+#include <algorithm>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define MIGRAPHX_CPU_F16C 1
+#else
+#define MIGRAPHX_CPU_F16C 0
+#endif
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+// The F16C instructions read the bits of the half values directly
+static_assert(sizeof(half) == 2, "half must be stored in 16 bits");
+
+#if MIGRAPHX_CPU_F16C
+__attribute__((target("avx,f16c"))) static void
+convert_f16c(const half* src, float* dst, std::size_t n)
+{
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(x));
+    }
+    for(; i < n; i++)
+        dst[i] = float(src[i]);
+}
+
+__attribute__((target("avx,f16c"))) static void
+convert_f16c(const float* src, half* dst, std::size_t n)
+{
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        __m128i x = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), x);
+    }
+    for(; i < n; i++)
+        dst[i] = half(src[i]);
+}
+
+static bool has_f16c()
+{
+    static const bool result = __builtin_cpu_supports("avx") and __builtin_cpu_supports("f16c");
+    return result;
+}
+#endif
+
+void convert(const half* src, float* dst, std::size_t n)
+{
+#if MIGRAPHX_CPU_F16C
+    if(has_f16c())
+    {
+        convert_f16c(src, dst, n);
+        return;
+    }
+#endif
+    std::transform(src, src + n, dst, [](half x) { return float(x); });
+}
+
+void convert(const float* src, half* dst, std::size_t n)
+{
+#if MIGRAPHX_CPU_F16C
+    if(has_f16c())
+    {
+        convert_f16c(src, dst, n);
+        return;
+    }
+#endif
+    std::transform(src, src + n, dst, [](float x) { return half(x); });
+}
+
+// The number of elements in the buffer of the argument, including the ones
+// skipped by its strides
+static std::size_t buffer_size(const shape& s) { return s.bytes() / s.type_size(); }
+
+template <class T, class U>
+static void parallel_convert(const T* src, U* dst, std::size_t n)
+{
+    const std::size_t chunk = 4096;
+    par_for((n + chunk - 1) / chunk, 1, [&](std::size_t i) {
+        convert(src + i * chunk, dst + i * chunk, std::min(chunk, n - i * chunk));
+    });
+}
+
+argument to_float(const argument& a)
+{
+    const auto& s = a.get_shape();
+    if(s.type() != shape::half_type)
+        MIGRAPHX_THROW("TO_FLOAT: Expected a half argument");
+    argument result{shape{shape::float_type, s.lens(), s.strides()}};
+    parallel_convert(reinterpret_cast<const half*>(a.data()),
+                     reinterpret_cast<float*>(result.data()),
+                     buffer_size(s));
+    return result;
+}
+
+void from_float(const argument& result, const argument& a)
+{
+    const auto& s = a.get_shape();
+    if(s.type() != shape::float_type or result.get_shape().type() != shape::half_type or
+       buffer_size(result.get_shape()) != buffer_size(s))
+        MIGRAPHX_THROW("FROM_FLOAT: Expected a float argument and a half result of the same size");
+    parallel_convert(reinterpret_cast<const float*>(a.data()),
+                     reinterpret_cast<half*>(result.data()),
+                     buffer_size(s));
+}
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
@@ -0,0 +1,324 @@
+#include <migraphx/cpu/fuse_ops.hpp>
+#include <migraphx/cpu/context.hpp>
+#include <migraphx/cpu/convert.hpp>
+#include <migraphx/check_shapes.hpp>
+#include <migraphx/instruction.hpp>
+#include <migraphx/iterator_for.hpp>
+#include <migraphx/shape_for_each.hpp>
+#include <migraphx/stringutils.hpp>
+#include <migraphx/par_for.hpp>
+#include <migraphx/serialize.hpp>
+#include <algorithm>
+#include <unordered_set>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+// One operator of a fused expression. The inputs refer first to the inputs of
+// the fused operator and then to the results of the previous nodes.
+struct pointwise_node
+{
+    operation op;
+    std::vector<std::size_t> inputs;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return pack(f(self.op, "op"), f(self.inputs, "inputs"));
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const pointwise_node& x)
+    {
+        os << x.op << "(" << to_string_range(x.inputs) << ")";
+        return os;
+    }
+
+    friend bool operator==(const pointwise_node& x, const pointwise_node& y)
+    {
+        return x.op == y.op and x.inputs == y.inputs;
+    }
+};
+
+template <class T>
+static std::vector<T>& pointwise_scratch(std::size_t n)
+{
+    static thread_local std::vector<T> buffer;
+    if(buffer.size() < n)
+        buffer.resize(n);
+    return buffer;
+}
+
+struct cpu_fused_pointwise
+{
+    std::vector<pointwise_node> nodes;
+
+    // Number of elements evaluated at once by each node, small enough that
+    // the intermediate results stay in cache
+    static constexpr std::size_t chunk = 2048;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return pack(f(self.nodes, "nodes"));
+    }
+
+    std::string name() const { return "cpu::fused_pointwise"; }
+    shape compute_shape(std::vector<shape> inputs) const
+    {
+        check_shapes{inputs, *this}.same_type().same_dims();
+        if(inputs.size() < 2)
+            MIGRAPHX_THROW("FUSED_POINTWISE: Expected an input and an output");
+        inputs.pop_back();
+        return {inputs.front().type(), inputs.front().lens()};
+    }
+
+    // The half values of each chunk are converted to float, so every node
+    // computes in float
+    void compute_half(migraphx::context& gctx,
+                      const argument& result,
+                      const std::vector<argument>& args) const
+    {
+        const std::size_t n = result.get_shape().elements();
+        const std::size_t m = args.size();
+        std::vector<offset_walker<1>> walkers;
+        std::transform(args.begin(), args.end(), std::back_inserter(walkers), [](auto&& arg) {
+            return offset_walker<1>{std::array<shape, 1>{{arg.get_shape()}}};
+        });
+        auto* output             = reinterpret_cast<half*>(result.data());
+        const std::size_t chunks = (n + chunk - 1) / chunk;
+        par_for(chunks, 1, [&](std::size_t c) {
+            const std::size_t start = c * chunk;
+            const std::size_t len   = std::min(chunk, n - start);
+            shape s{shape::float_type, {len}};
+            auto& buffer = pointwise_scratch<float>(chunk * (m + nodes.size()));
+            std::vector<argument> slots;
+            slots.reserve(m + nodes.size());
+            for(std::size_t i = 0; i < m; i++)
+            {
+                float* dst      = buffer.data() + i * chunk;
+                const half* src = reinterpret_cast<const half*>(args[i].data());
+                slots.emplace_back(s, dst);
+                if(args[i].get_shape().standard())
+                    convert(src + start, dst, len);
+                else
+                    walkers[i](start, start + len, [&](auto j) { *dst++ = float(src[j]); });
+            }
+            for(std::size_t k = 0; k < nodes.size(); k++)
+            {
+                std::vector<argument> node_args;
+                std::transform(nodes[k].inputs.begin(),
+                               nodes[k].inputs.end(),
+                               std::back_inserter(node_args),
+                               [&](auto i) { return slots[i]; });
+                node_args.emplace_back(s, buffer.data() + (m + k) * chunk);
+                slots.push_back(nodes[k].op.compute(gctx, s, node_args));
+            }
+            convert(reinterpret_cast<const float*>(slots.back().data()), output + start, len);
+        });
+    }
+
+    argument compute(context& ctx, const shape& output_shape, std::vector<argument> args) const
+    {
+        argument result = args.back();
+        args.pop_back();
+        // The nodes are type-erased operators, which need a type-erased context
+        migraphx::context gctx = ctx;
+        if(output_shape.type() == shape::half_type)
+        {
+            compute_half(gctx, result, args);
+            return result;
+        }
+        const std::size_t n = output_shape.elements();
+        const std::size_t m = args.size();
+        result.visit([&](auto output) {
+            using type = typename decltype(output)::value_type;
+            std::vector<type*> inputs;
+            std::vector<offset_walker<1>> walkers;
+            std::vector<std::size_t> strided;
+            for(std::size_t i = 0; i < m; i++)
+            {
+                inputs.push_back(args[i].get<type>().data());
+                if(args[i].get_shape().standard())
+                    continue;
+                strided.push_back(i);
+                walkers.emplace_back(std::array<shape, 1>{{args[i].get_shape()}});
+            }
+            const std::size_t chunks = (n + chunk - 1) / chunk;
+            par_for(chunks, 1, [&](std::size_t c) {
+                const std::size_t start = c * chunk;
+                const std::size_t len   = std::min(chunk, n - start);
+                shape s{output_shape.type(), {len}};
+                auto& buffer = pointwise_scratch<type>(chunk * (strided.size() + nodes.size()));
+                std::vector<argument> slots;
+                slots.reserve(m + nodes.size());
+                for(std::size_t i = 0; i < m; i++)
+                    slots.emplace_back(s, inputs[i] + start);
+                // Gather the inputs that are not standard, so every node
+                // works on contiguous data
+                for(std::size_t k = 0; k < strided.size(); k++)
+                {
+                    type* dst       = buffer.data() + k * chunk;
+                    const type* src = inputs[strided[k]];
+                    walkers[k](start, start + len, [&](auto j) { *dst++ = src[j]; });
+                    slots[strided[k]] = argument{s, buffer.data() + k * chunk};
+                }
+                for(std::size_t k = 0; k < nodes.size(); k++)
+                {
+                    // The last node writes to the output
+                    type* out = k + 1 == nodes.size()
+                                    ? output.data() + start
+                                    : buffer.data() + (strided.size() + k) * chunk;
+                    std::vector<argument> node_args;
+                    std::transform(nodes[k].inputs.begin(),
+                                   nodes[k].inputs.end(),
+                                   std::back_inserter(node_args),
+                                   [&](auto i) { return slots[i]; });
+                    node_args.emplace_back(s, out);
+                    slots.push_back(nodes[k].op.compute(gctx, s, node_args));
+                }
+            });
+        });
+        return result;
+    }
+
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
+    {
+        return shapes.size() - 1;
+    }
+};
+
+static const bool fused_pointwise_registered = register_ops<cpu_fused_pointwise>();
+
+static bool is_pointwise(instruction_ref ins)
+{
+    static const std::unordered_set<std::string> names = {
+        "cpu::identity", "cpu::abs",     "cpu::exp",        "cpu::log",  "cpu::sin",
+        "cpu::cos",      "cpu::tan",     "cpu::asin",       "cpu::acos", "cpu::atan",
+        "cpu::sinh",     "cpu::cosh",    "cpu::tanh",       "cpu::sigmoid", "cpu::erf",
+        "cpu::neg",      "cpu::relu",    "cpu::clip",       "cpu::leaky_relu", "cpu::elu",
+        "cpu::add",      "cpu::sub",     "cpu::mul",        "cpu::div",  "cpu::max",
+        "cpu::min",      "cpu::fused_pointwise"};
+    return names.count(ins->name()) > 0;
+}
+
+// A fused expression with the instructions it reads from
+struct pointwise_expr
+{
+    std::vector<instruction_ref> inputs;
+    std::vector<pointwise_node> nodes;
+
+    explicit pointwise_expr(instruction_ref ins)
+    {
+        // The last input is the output buffer
+        std::vector<instruction_ref> args(ins->inputs().begin(), std::prev(ins->inputs().end()));
+        // The fused operator gathers strided inputs itself, so a contiguous
+        // is just its input
+        if(ins->name() == "cpu::fused_pointwise" or ins->name() == "cpu::contiguous")
+        {
+            inputs = args;
+            if(ins->name() == "cpu::contiguous")
+                return;
+            nodes  = any_cast<cpu_fused_pointwise>(ins->get_operator()).nodes;
+            return;
+        }
+        pointwise_node node{ins->get_operator(), {}};
+        std::transform(args.begin(), args.end(), std::back_inserter(node.inputs), [&](auto arg) {
+            return this->add_input(arg);
+        });
+        nodes.push_back(node);
+    }
+
+    std::size_t add_input(instruction_ref ins)
+    {
+        auto it = std::find(inputs.begin(), inputs.end(), ins);
+        if(it != inputs.end())
+            return it - inputs.begin();
+        inputs.push_back(ins);
+        return inputs.size() - 1;
+    }
+
+    // Substitute the expression of the input `x` into this expression
+    void merge(instruction_ref ins, const pointwise_expr& x)
+    {
+        std::vector<instruction_ref> old_inputs;
+        std::swap(inputs, old_inputs);
+        for(auto input : old_inputs)
+        {
+            if(input != ins)
+                add_input(input);
+        }
+        std::vector<std::size_t> x_inputs;
+        std::transform(x.inputs.begin(),
+                       x.inputs.end(),
+                       std::back_inserter(x_inputs),
+                       [&](auto input) { return this->add_input(input); });
+
+        const std::size_t n = inputs.size();
+        std::vector<pointwise_node> result;
+        for(auto node : x.nodes)
+        {
+            for(auto& i : node.inputs)
+                i = i < x.inputs.size() ? x_inputs[i] : n + i - x.inputs.size();
+            result.push_back(node);
+        }
+        const std::size_t x_result =
+            x.nodes.empty() ? x_inputs.front() : n + x.nodes.size() - 1;
+        for(auto node : nodes)
+        {
+            for(auto& i : node.inputs)
+            {
+                if(i >= old_inputs.size())
+                    i = n + x.nodes.size() + i - old_inputs.size();
+                else if(old_inputs[i] == ins)
+                    i = x_result;
+                else
+                    i = add_input(old_inputs[i]);
+            }
+            result.push_back(node);
+        }
+        nodes = result;
+    }
+};
+
+// The input can be fused when this instruction is the only one reading it
+static bool can_fuse(instruction_ref ins, instruction_ref input)
+{
+    return (is_pointwise(input) or input->name() == "cpu::contiguous") and
+           input->get_shape().standard() and
+           std::all_of(input->outputs().begin(), input->outputs().end(), [&](auto output) {
+               return output == ins;
+           });
+}
+
+void fuse_ops::apply(program& p) const
+{
+    for(auto ins : iterator_for(p))
+    {
+        if(not is_pointwise(ins) or not ins->get_shape().standard())
+            continue;
+        pointwise_expr expr{ins};
+        auto args = expr.inputs;
+        // A half operator is fused even when it is alone, so it is computed
+        // in float
+        const bool half_op =
+            ins->get_shape().type() == shape::half_type and ins->name() != "cpu::fused_pointwise";
+        if(not half_op and
+           std::none_of(args.begin(), args.end(), [&](auto input) { return can_fuse(ins, input); }))
+            continue;
+        // The instructions are visited in program order, so the inputs have
+        // already absorbed their own inputs
+        for(auto input : args)
+        {
+            if(can_fuse(ins, input))
+                expr.merge(input, pointwise_expr{input});
+        }
+        auto inputs = expr.inputs;
+        inputs.push_back(ins->inputs().back());
+        p.replace_instruction(ins, cpu_fused_pointwise{expr.nodes}, inputs);
+    }
+}
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
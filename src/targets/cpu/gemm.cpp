@@ -1,123 +1,479 @@
 #include <migraphx/cpu/gemm.hpp>
-#include <migraphx/dfor.hpp>
-#include <migraphx/requires.hpp>
-#include <migraphx/shape_for_each.hpp>
-#include <blaze/math/CustomMatrix.h>
+#include <migraphx/cpu/vectorize.hpp>
+#include <migraphx/cpu/convert.hpp>
+#include <migraphx/half.hpp>
+#include <migraphx/errors.hpp>
+#include <migraphx/par_for.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <vector>
 
 namespace migraphx {
 inline namespace MIGRAPHX_INLINE_NS {
 namespace cpu {
 
+// The type the products are accumulated in, unless double precision is
+// selected
 template <class T>
-using matrix = blaze::CustomMatrix<T, blaze::unaligned, blaze::unpadded>; // NOLINT
+struct gemm_compute
+{
+    using type = double;
+};
 
-template <class T>
-static auto make_mat(tensor_view<T> x)
+template <>
+struct gemm_compute<float>
 {
-    const auto& s = x.get_shape();
-    // assert(s.lens().size() == 2);
-    std::size_t n_dims = s.lens().size();
-    std::size_t dim_0  = n_dims - 2;
-    std::size_t dim_1  = n_dims - 1;
-    if(s.transposed())
-        return matrix<T>{x.data(), s.lens()[dim_1], s.lens()[dim_0], s.strides()[dim_1]};
-    return matrix<T>{x.data(), s.lens()[dim_0], s.lens()[dim_1], s.strides()[dim_0]};
+    using type = float;
+};
+
+template <>
+struct gemm_compute<half>
+{
+    using type = float;
+};
+
+// Sizes of the tiles kept in registers by the micro kernel
+template <class U>
+struct gemm_tile
+{
+    static constexpr std::size_t mr = 6;
+    static constexpr std::size_t nr = 64 / sizeof(U);
+};
+
+// Sizes of the blocks of A and B that are packed so they stay in cache
+constexpr std::size_t gemm_mc = 72;
+constexpr std::size_t gemm_nc = 256;
+constexpr std::size_t gemm_kc = 256;
+
+#ifdef __GNUC__
+template <class U>
+struct gemm_vector;
+
+template <>
+struct gemm_vector<float>
+{
+    typedef float type __attribute__((vector_size(64))); // NOLINT
+};
+
+template <>
+struct gemm_vector<double>
+{
+    typedef double type __attribute__((vector_size(64))); // NOLINT
+};
+
+template <>
+struct gemm_vector<int32_t>
+{
+    typedef int32_t type __attribute__((vector_size(64))); // NOLINT
+};
+#endif
+
+// Multiply a packed MR x kc panel of A by a packed kc x NR panel of B
+template <class U>
+MIGRAPHX_CPU_INLINE void micro_kernel(std::size_t kc, const U* a, const U* b, U* c)
+{
+    constexpr std::size_t mr = gemm_tile<U>::mr;
+    constexpr std::size_t nr = gemm_tile<U>::nr;
+#ifdef __GNUC__
+    // Keep each row of the tile in one vector so the compiler does not try
+    // to vectorize across k instead
+    using vec = typename gemm_vector<U>::type;
+    static_assert(sizeof(vec) == nr * sizeof(U), "The vector must hold a row of the tile");
+    vec acc[mr] = {};
+    for(std::size_t k = 0; k < kc; k++)
+    {
+        vec bv;
+        std::memcpy(&bv, b, sizeof(bv));
+        for(std::size_t i = 0; i < mr; i++)
+            acc[i] += a[i] * bv;
+        a += mr;
+        b += nr;
+    }
+    std::memcpy(c, acc, sizeof(acc));
+#else
+    U acc[mr][nr] = {};
+    for(std::size_t k = 0; k < kc; k++)
+    {
+        for(std::size_t i = 0; i < mr; i++)
+        {
+            for(std::size_t j = 0; j < nr; j++)
+                acc[i][j] += a[i] * b[j];
+        }
+        a += mr;
+        b += nr;
+    }
+    for(std::size_t i = 0; i < mr; i++)
+        std::copy(acc[i], acc[i] + nr, c + i * nr);
+#endif
 }
 
-template <class T, class F>
-static void visit_mat(tensor_view<T> x, F f)
+MIGRAPHX_CPU_TARGETS
+static void gemm_kernel(std::size_t kc, const float* a, const float* b, float* c)
 {
-    auto mat = make_mat(x);
-    if(x.get_shape().transposed())
-        f(blaze::trans(mat));
-    else
-        f(mat);
+    micro_kernel(kc, a, b, c);
 }
 
+MIGRAPHX_CPU_TARGETS
+static void gemm_kernel(std::size_t kc, const double* a, const double* b, double* c)
+{
+    micro_kernel(kc, a, b, c);
+}
+
+MIGRAPHX_CPU_TARGETS
+static void gemm_kernel(std::size_t kc, const int32_t* a, const int32_t* b, int32_t* c)
+{
+    micro_kernel(kc, a, b, c);
+}
+
+// A strided view of one matrix in a batch
 template <class T>
-struct is_fast_gemm_type : std::false_type
+struct matrix_view
 {
+    T* data;
+    std::size_t row_stride;
+    std::size_t col_stride;
+
+    T& operator()(std::size_t i, std::size_t j) const
+    {
+        return data[i * row_stride + j * col_stride];
+    }
 };
 
-template <>
-struct is_fast_gemm_type<float> : std::true_type
+// Offset of the matrix at batch index b, which works for broadcasted and
+// transposed batch dimensions
+static std::size_t batch_offset(const shape& s, std::size_t b)
 {
-};
+    const auto& lens    = s.lens();
+    const auto& strides = s.strides();
+    std::size_t result  = 0;
+    for(std::size_t d = lens.size() - 2; d > 0; d--)
+    {
+        result += (b % lens[d - 1]) * strides[d - 1];
+        b /= lens[d - 1];
+    }
+    return result;
+}
 
 template <class T>
-void migemm_impl(tensor_view<T> cmat,
-                 tensor_view<T> amat,
-                 tensor_view<T> bmat,
-                 float alpha,
-                 float beta,
-                 std::true_type)
-{
-    visit_mat(amat, [&](const auto& a) {
-        visit_mat(bmat, [&](const auto& b) {
-            auto c = make_mat(cmat);
-            c      = beta * c;
-            // This is a simple optimization to avoid
-            // compute A * B if alpha is 0.0
-            if(alpha != 0.0)
+static matrix_view<T> make_matrix(tensor_view<T> x, std::size_t b)
+{
+    const auto& s      = x.get_shape();
+    std::size_t n_dims = s.lens().size();
+    return {x.data() + batch_offset(s, b), s.strides()[n_dims - 2], s.strides()[n_dims - 1]};
+}
+
+template <class T>
+static matrix_view<T> transpose_matrix(matrix_view<T> m)
+{
+    return {m.data, m.col_stride, m.row_stride};
+}
+
+// Pack the rows of `m` into panels of `w` rows stored as [panel][k][w], so the
+// micro kernel reads each panel with unit stride. The last panel is padded
+// with zeros so the kernel always works on full tiles.
+template <class type, class T>
+static void
+pack_panels(matrix_view<T> m, std::size_t rows, std::size_t k, std::size_t w, type* dst)
+{
+    const std::size_t panels = (rows + w - 1) / w;
+    for(std::size_t p = 0; p < panels; p++)
+    {
+        for(std::size_t kk = 0; kk < k; kk++)
+        {
+            for(std::size_t i = 0; i < w; i++)
             {
-                c = c + alpha * a * b;
+                std::size_t row = p * w + i;
+                *dst++          = row < rows ? type(m(row, kk)) : type(0);
             }
-        });
-    });
+        }
+    }
 }
 
-template <class T>
+// Compute one mc x nc block of C for every kc block of the inner dimension.
+// An operand that was packed by pack_gemm_operand is read from its panels,
+// otherwise the panels of the block are packed here.
+template <class type, class T, class U>
+static void gemm_block(matrix_view<T> cmat,
+                       matrix_view<U> amat,
+                       matrix_view<U> bmat,
+                       std::size_t mc,
+                       std::size_t nc,
+                       std::size_t k,
+                       float alpha,
+                       float beta,
+                       const type* apacked,
+                       const type* bpacked)
+{
+    constexpr std::size_t mr = gemm_tile<type>::mr;
+    constexpr std::size_t nr = gemm_tile<type>::nr;
+
+    const std::size_t m_panels = (mc + mr - 1) / mr;
+    const std::size_t n_panels = (nc + nr - 1) / nr;
+
+    // Reuse the packing buffers between calls on the same thread
+    static thread_local std::vector<type> apack;
+    static thread_local std::vector<type> bpack;
+    if(apacked == nullptr)
+        apack.resize(m_panels * mr * std::min(k, gemm_kc));
+    if(bpacked == nullptr)
+        bpack.resize(n_panels * nr * std::min(k, gemm_kc));
+    type acc[mr * nr];
+
+    for(std::size_t pc = 0; pc < k; pc += gemm_kc)
+    {
+        const std::size_t kc = std::min(gemm_kc, k - pc);
+        const type* a_panels = apack.data();
+        const type* b_panels = bpack.data();
+        std::size_t a_stride = kc * mr;
+        std::size_t b_stride = kc * nr;
+        if(apacked != nullptr)
+        {
+            a_panels = apacked + pc * mr;
+            a_stride = k * mr;
+        }
+        else
+        {
+            matrix_view<U> a{amat.data + pc * amat.col_stride, amat.row_stride, amat.col_stride};
+            pack_panels(a, mc, kc, mr, apack.data());
+        }
+        if(bpacked != nullptr)
+        {
+            b_panels = bpacked + pc * nr;
+            b_stride = k * nr;
+        }
+        else
+        {
+            matrix_view<U> b{bmat.data + pc * bmat.row_stride, bmat.row_stride, bmat.col_stride};
+            pack_panels(transpose_matrix(b), nc, kc, nr, bpack.data());
+        }
+
+        const bool first = pc == 0;
+        for(std::size_t jp = 0; jp < n_panels; jp++)
+        {
+            for(std::size_t ip = 0; ip < m_panels; ip++)
+            {
+                gemm_kernel(kc, a_panels + ip * a_stride, b_panels + jp * b_stride, acc);
+                const std::size_t rows = std::min(mr, mc - ip * mr);
+                const std::size_t cols = std::min(nr, nc - jp * nr);
+                for(std::size_t i = 0; i < rows; i++)
+                {
+                    for(std::size_t j = 0; j < cols; j++)
+                    {
+                        auto& c = cmat(ip * mr + i, jp * nr + j);
+                        // Integer products stay exact when alpha is 1
+                        type ab = alpha == 1.0f ? acc[i * nr + j] : type(alpha * acc[i * nr + j]);
+                        // The output buffer may be reused memory, so it is not
+                        // read when beta is 0.0 as it could contain nan or inf
+                        if(not first)
+                            c = T(type(c) + ab);
+                        else if(beta == 0.0f)
+                            c = T(ab);
+                        else
+                            c = T(ab + beta * type(c));
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <class type, class T, class U>
 void migemm_impl(tensor_view<T> cmat,
-                 tensor_view<T> amat,
-                 tensor_view<T> bmat,
+                 tensor_view<U> amat,
+                 tensor_view<U> bmat,
                  float alpha,
                  float beta,
-                 std::false_type)
-{
-    std::size_t n_dims = cmat.get_shape().lens().size();
-    std::size_t dim_0  = n_dims - 2;
-    std::size_t dim_1  = n_dims - 1;
-    auto k             = amat.get_shape().lens()[dim_1];
-
-    assert(amat.get_shape().lens()[dim_1] == bmat.get_shape().lens()[dim_0]);
-    assert(cmat.get_shape().lens()[dim_0] == amat.get_shape().lens()[dim_0]);
-    assert(cmat.get_shape().lens()[dim_1] == bmat.get_shape().lens()[dim_1]);
-
-    shape_for_each(cmat.get_shape(), [&](const auto& c_idx) {
-        auto a_idx = c_idx;
-        auto b_idx = c_idx;
-        double s   = 0.0;
-        dfor(k)([&](auto kk) {
-            a_idx[dim_1] = b_idx[dim_0] = kk;
-            s += amat(a_idx.begin(), a_idx.end()) * bmat(b_idx.begin(), b_idx.end());
-        });
-        cmat(c_idx.begin(), c_idx.end()) = alpha * s + cmat(c_idx.begin(), c_idx.end()) * beta;
-    });
-}
+                 const type* apacked = nullptr,
+                 const type* bpacked = nullptr)
+{
+    constexpr std::size_t mr = gemm_tile<type>::mr;
+    constexpr std::size_t nr = gemm_tile<type>::nr;
+    static_assert(gemm_mc % mr == 0 and gemm_nc % nr == 0,
+                  "The blocks must start on the panels of the packed operands");
 
-template <class T>
-void migemm_impl(
-    tensor_view<T> cmat, tensor_view<T> amat, tensor_view<T> bmat, float alpha, float beta)
-{
-    auto lens = amat.get_shape().lens();
-    bool batch_mul =
-        std::accumulate(
-            lens.rbegin() + 2, lens.rend(), std::size_t{1}, std::multiplies<std::size_t>()) == 1;
-    if(batch_mul)
+    const auto& lens   = cmat.get_shape().lens();
+    std::size_t n_dims = lens.size();
+    std::size_t m      = lens[n_dims - 2];
+    std::size_t n      = lens[n_dims - 1];
+    std::size_t k      = amat.get_shape().lens()[n_dims - 1];
+    std::size_t batch  = cmat.get_shape().elements() / std::max<std::size_t>(m * n, 1);
+
+    assert(amat.get_shape().lens()[n_dims - 1] == bmat.get_shape().lens()[n_dims - 2]);
+    assert(cmat.get_shape().lens()[n_dims - 2] == amat.get_shape().lens()[n_dims - 2]);
+    assert(cmat.get_shape().lens()[n_dims - 1] == bmat.get_shape().lens()[n_dims - 1]);
+
+    if(m * n == 0)
+        return;
+    if(k == 0)
     {
-        migemm_impl(cmat, amat, bmat, alpha, beta, is_fast_gemm_type<T>{});
+        for(std::size_t b = 0; b < batch; b++)
+        {
+            auto c = make_matrix(cmat, b);
+            for(std::size_t i = 0; i < m; i++)
+                for(std::size_t j = 0; j < n; j++)
+                    c(i, j) = beta == 0.0f ? T(0) : T(beta * type(c(i, j)));
+        }
+        return;
     }
+
+    // Each task computes one block of C, so the batches and the blocks are
+    // all computed in parallel
+    const std::size_t m_blocks = (m + gemm_mc - 1) / gemm_mc;
+    const std::size_t n_blocks = (n + gemm_nc - 1) / gemm_nc;
+    par_for(batch * m_blocks * n_blocks, 1, [&](std::size_t task) {
+        const std::size_t b  = task / (m_blocks * n_blocks);
+        const std::size_t ic = ((task / n_blocks) % m_blocks) * gemm_mc;
+        const std::size_t jc = (task % n_blocks) * gemm_nc;
+
+        auto c  = make_matrix(cmat, b);
+        auto a  = make_matrix(amat, b);
+        auto bm = make_matrix(bmat, b);
+        c.data += ic * c.row_stride + jc * c.col_stride;
+        // The views of the packed operands have no data
+        if(apacked == nullptr)
+            a.data += ic * a.row_stride;
+        if(bpacked == nullptr)
+            bm.data += jc * bm.col_stride;
+        gemm_block<type>(c,
+                         a,
+                         bm,
+                         std::min(gemm_mc, m - ic),
+                         std::min(gemm_nc, n - jc),
+                         k,
+                         alpha,
+                         beta,
+                         apacked == nullptr ? nullptr : apacked + (ic / mr) * k * mr,
+                         bpacked == nullptr ? nullptr : bpacked + (jc / nr) * k * nr);
+    });
+}
+
+// Call f with a zero of the type the products of matrices of type T are
+// accumulated in, which is also the type their packed panels are stored in
+template <class T, class F>
+static void visit_gemm_type(accumulate acc, F f)
+{
+    if(acc == accumulate::double_precision)
+        f(double{});
     else
+        f(typename gemm_compute<T>::type{});
+}
+
+argument pack_gemm_operand(const argument& m, gemm_operand operand, accumulate acc)
+{
+    const auto& s      = m.get_shape();
+    const auto& lens   = s.lens();
+    std::size_t n_dims = lens.size();
+    if(n_dims < 2)
+        MIGRAPHX_THROW("PACK_GEMM_OPERAND: Expected a matrix");
+    if(s.type() == shape::int8_type)
+        MIGRAPHX_THROW("PACK_GEMM_OPERAND: int8 matrices are not packed");
+    // The panels of A run along its rows and the panels of B along its columns
+    const bool is_a       = operand == gemm_operand::a;
+    const std::size_t k   = lens[is_a ? n_dims - 1 : n_dims - 2];
+    const std::size_t n   = lens[is_a ? n_dims - 2 : n_dims - 1];
+    const std::size_t mat = std::max<std::size_t>(n * k, 1);
+    argument result;
+    m.visit([&](auto x) {
+        using value_type = typename decltype(x)::value_type;
+        visit_gemm_type<value_type>(acc, [&](auto zero) {
+            using type = decltype(zero);
+            const std::size_t w =
+                is_a ? std::size_t{gemm_tile<type>::mr} : std::size_t{gemm_tile<type>::nr};
+            const std::size_t size  = (n + w - 1) / w * w * k;
+            const std::size_t batch = s.elements() / mat;
+
+            // A batch of matrices is packed one after the other
+            result    = argument{shape{shape::get_type<type>{}, {batch * size}}};
+            auto* dst = reinterpret_cast<type*>(result.data());
+            par_for(batch, 1, [&](std::size_t b) {
+                auto v = make_matrix(x, b);
+                pack_panels(is_a ? v : transpose_matrix(v), n, k, w, dst + b * size);
+            });
+        });
+    });
+    return result;
+}
+
+void migemm_packed(const argument& c_arg,
+                   const argument& a_arg,
+                   const argument& b_arg,
+                   gemm_operand packed,
+                   float alpha,
+                   float beta,
+                   accumulate acc)
+{
+    const bool is_a      = packed == gemm_operand::a;
+    const auto& cs       = c_arg.get_shape();
+    const argument& x    = is_a ? b_arg : a_arg;
+    const argument& pmat = is_a ? a_arg : b_arg;
+    if(cs.lens().size() != 2 or x.get_shape().lens().size() != 2)
+        MIGRAPHX_THROW("MIGEMM_PACKED: Only 2-d matrices are supported");
+    if(cs.type() == shape::half_type)
     {
-        migemm_impl(cmat, amat, bmat, alpha, beta, std::false_type{});
+        argument c = beta == 0.0f ? argument{shape{shape::float_type, cs.lens(), cs.strides()}}
+                                  : to_float(c_arg);
+        auto xf    = to_float(x);
+        migemm_packed(c, is_a ? pmat : xf, is_a ? xf : pmat, packed, alpha, beta, acc);
+        from_float(c_arg, c);
+        return;
     }
+
+    // The shape of the packed operand before it was packed
+    const auto& xl = x.get_shape().lens();
+    shape ps{x.get_shape().type(),
+             is_a ? std::vector<std::size_t>{cs.lens()[0], xl[0]}
+                  : std::vector<std::size_t>{xl[1], cs.lens()[1]}};
+    visit_all(c_arg, x)([&](auto cmat, auto xmat) {
+        using value_type = typename decltype(xmat)::value_type;
+        visit_gemm_type<value_type>(acc, [&](auto zero) {
+            using type = decltype(zero);
+            if(pmat.get_shape().type() != shape::get_type<type>{})
+                MIGRAPHX_THROW("MIGEMM_PACKED: The operand was packed for another accumulation");
+            const auto* p = reinterpret_cast<const type*>(pmat.data());
+            auto view     = make_view(ps, static_cast<value_type*>(nullptr));
+            if(is_a)
+                migemm_impl<type>(cmat, view, xmat, alpha, beta, p, nullptr);
+            else
+                migemm_impl<type>(cmat, xmat, view, alpha, beta, nullptr, p);
+        });
+    });
 }
 
-void migemm(
-    const argument& c_arg, const argument& a_arg, const argument& b_arg, float alpha, float beta)
+void migemm(const argument& c_arg,
+            const argument& a_arg,
+            const argument& b_arg,
+            float alpha,
+            float beta,
+            accumulate acc)
 {
-    visit_all(c_arg, a_arg, b_arg)(
-        [&](auto cmat, auto amat, auto bmat) { migemm_impl(cmat, amat, bmat, alpha, beta); });
+    // The products of int8 matrices are accumulated exactly in int32
+    if(a_arg.get_shape().type() == shape::int8_type and
+       c_arg.get_shape().type() == shape::int32_type)
+    {
+        assert(b_arg.get_shape().type() == shape::int8_type);
+        migemm_impl<int32_t>(
+            c_arg.get<int32_t>(), a_arg.get<int8_t>(), b_arg.get<int8_t>(), alpha, beta);
+        return;
+    }
+    // Converting the half matrices to float in bulk is much faster than
+    // converting each element while the panels are packed
+    if(c_arg.get_shape().type() == shape::half_type)
+    {
+        const auto& cs = c_arg.get_shape();
+        argument c     = beta == 0.0f
+                         ? argument{shape{shape::float_type, cs.lens(), cs.strides()}}
+                         : to_float(c_arg);
+        migemm(c, to_float(a_arg), to_float(b_arg), alpha, beta, acc);
+        from_float(c_arg, c);
+        return;
+    }
+    visit_all(c_arg, a_arg, b_arg)([&](auto cmat, auto amat, auto bmat) {
+        using value_type = typename decltype(cmat)::value_type;
+        visit_gemm_type<value_type>(acc, [&](auto zero) {
+            migemm_impl<decltype(zero)>(cmat, amat, bmat, alpha, beta);
+        });
+    });
 }
 
 } // namespace cpu
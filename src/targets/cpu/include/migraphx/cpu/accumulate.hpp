@@ -0,0 +1,67 @@
+#ifndef MIGRAPHX_GUARD_RTGLIB_CPU_ACCUMULATE_HPP
+#define MIGRAPHX_GUARD_RTGLIB_CPU_ACCUMULATE_HPP
+
+#include <migraphx/errors.hpp>
+#include <migraphx/half.hpp>
+#include <migraphx/config.hpp>
+#include <cstdint>
+#include <ostream>
+#include <type_traits>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+/// The precision the convolution, pooling and gemm kernels accumulate in. Integers are
+/// accumulated in 64 bits unless double precision is selected.
+enum class accumulate
+{
+    /// Accumulate floating point values in their own type
+    native,
+    /// Accumulate half values in float, and other floating point values in their own type
+    mixed,
+    /// Accumulate everything in double, to compute reference results
+    double_precision
+};
+
+std::ostream& operator<<(std::ostream& os, accumulate v);
+
+namespace detail {
+
+template <class T>
+struct mixed_accumulator
+{
+    using type = T;
+};
+
+template <>
+struct mixed_accumulator<half>
+{
+    using type = float;
+};
+
+} // namespace detail
+
+/// Call `f` with a value of the type that elements of type `T` are accumulated in
+template <class T, class F>
+void visit_accumulator(accumulate a, F f)
+{
+    using integral = std::is_integral<T>;
+    switch(a)
+    {
+    case accumulate::native: f(std::conditional_t<integral{}, std::int64_t, T>{}); return;
+    case accumulate::mixed:
+        f(std::conditional_t<integral{},
+                             std::int64_t,
+                             typename detail::mixed_accumulator<T>::type>{});
+        return;
+    case accumulate::double_precision: f(double{}); return;
+    }
+    MIGRAPHX_THROW("Unknown accumulation");
+}
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef MIGRAPHX_GUARD_RTGLIB_CPU_ADJUST_ALLOCATION_HPP
+#define MIGRAPHX_GUARD_RTGLIB_CPU_ADJUST_ALLOCATION_HPP
+
+#include <migraphx/program.hpp>
+#include <migraphx/config.hpp>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+/**
+ * Resize the allocations whose shape no longer matches the instruction writing to them, such as
+ * when eliminate_contiguous lets an operator read a transposed input and produce a transposed
+ * output.
+ */
+struct adjust_allocation
+{
+    std::string name() const { return "cpu::adjust_allocation"; }
+    void apply(program& p) const;
+};
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
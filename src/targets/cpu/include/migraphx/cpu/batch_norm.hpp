@@ -0,0 +1,23 @@
+#ifndef MIGRAPHX_GUARD_RTGLIB_CPU_BATCH_NORM_HPP
+#define MIGRAPHX_GUARD_RTGLIB_CPU_BATCH_NORM_HPP
+
+#include <migraphx/argument.hpp>
+#include <migraphx/config.hpp>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+/// Compute `result = input * scale + shift` for a 4-D input, where `scale` and `shift` have
+/// either one value per channel or one value per channel and pixel. NCHW and NHWC inputs are
+/// streamed over contiguous memory, other layouts are indexed.
+void scale_shift(const argument& result,
+                 const argument& input,
+                 const argument& scale,
+                 const argument& shift);
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
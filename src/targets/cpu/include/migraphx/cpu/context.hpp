@@ -1,7 +1,9 @@
 #ifndef MIGRAPHX_GUARD_RTGLIB_CONTEXT_HPP
 #define MIGRAPHX_GUARD_RTGLIB_CONTEXT_HPP
 
+#include <migraphx/argument.hpp>
 #include <migraphx/config.hpp>
+#include <vector>
 
 namespace migraphx {
 inline namespace MIGRAPHX_INLINE_NS {
@@ -9,6 +11,9 @@ namespace cpu {
 
 struct context
 {
+    // Buffers that are allocated once at compile time and reused by every eval
+    std::vector<argument> buffers{};
+
     void finish() const {}
 };
 
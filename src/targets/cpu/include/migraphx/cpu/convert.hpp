@@ -0,0 +1,28 @@
+#ifndef MIGRAPHX_GUARD_RTGLIB_CPU_CONVERT_HPP
+#define MIGRAPHX_GUARD_RTGLIB_CPU_CONVERT_HPP
+
+#include <migraphx/argument.hpp>
+#include <migraphx/half.hpp>
+#include <migraphx/config.hpp>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+/// Convert `n` half values to float, with the F16C instructions when the processor has them
+void convert(const half* src, float* dst, std::size_t n);
+
+/// Convert `n` float values to half, rounding to nearest even
+void convert(const float* src, half* dst, std::size_t n);
+
+/// Copy a half argument to a float argument with the same lens and strides
+argument to_float(const argument& a);
+
+/// Copy the values of a float argument into a half argument with the same lens and strides
+void from_float(const argument& result, const argument& a);
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
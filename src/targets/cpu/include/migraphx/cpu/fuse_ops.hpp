@@ -0,0 +1,25 @@
+#ifndef MIGRAPHX_GUARD_RTGLIB_CPU_FUSE_OPS_HPP
+#define MIGRAPHX_GUARD_RTGLIB_CPU_FUSE_OPS_HPP
+
+#include <migraphx/program.hpp>
+#include <migraphx/config.hpp>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+/**
+ * Collapse chains of lowered pointwise operators into a single `cpu::fused_pointwise` operator,
+ * so the intermediate results stay in cache instead of being written to memory.
+ */
+struct fuse_ops
+{
+    std::string name() const { return "cpu::fuse_ops"; }
+    void apply(program& p) const;
+};
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
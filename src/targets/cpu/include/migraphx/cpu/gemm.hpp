@@ -2,14 +2,49 @@
 #define MIGRAPHX_GUARD_RTGLIB_CPU_GEMM_HPP
 
 #include <migraphx/argument.hpp>
+#include <migraphx/cpu/accumulate.hpp>
 #include <migraphx/config.hpp>
 
 namespace migraphx {
 inline namespace MIGRAPHX_INLINE_NS {
 namespace cpu {
 
-void migemm(
-    const argument& c_arg, const argument& a_arg, const argument& b_arg, float alpha, float beta);
+/// Compute `C = alpha * A * B + beta * C`. The products of float and half matrices are
+/// accumulated in float, since there are no half kernels, unless double precision is selected.
+/// Half matrices are converted to float before they are multiplied. Int8 matrices are multiplied
+/// into an int32 matrix.
+void migemm(const argument& c_arg,
+            const argument& a_arg,
+            const argument& b_arg,
+            float alpha,
+            float beta,
+            accumulate acc = accumulate::mixed);
+
+/// The operand of the gemm that is packed
+enum class gemm_operand
+{
+    a,
+    b
+};
+
+/// Pack a matrix, or a batch of matrices one after the other, into the panels read by the gemm
+/// micro kernel. The panels are stored in the type the products are accumulated in. Constant
+/// weights are packed once when the program is compiled, so they are not packed again on every
+/// call.
+argument pack_gemm_operand(const argument& m,
+                           gemm_operand operand,
+                           accumulate acc = accumulate::mixed);
+
+/// Compute `C = alpha * A * B + beta * C` for 2-d matrices, where the `packed` operand was
+/// packed by `pack_gemm_operand` with the same accumulation. The shape of the packed operand
+/// is taken from the other matrices.
+void migemm_packed(const argument& c_arg,
+                   const argument& a_arg,
+                   const argument& b_arg,
+                   gemm_operand packed,
+                   float alpha,
+                   float beta,
+                   accumulate acc = accumulate::mixed);
 
 } // namespace cpu
 } // namespace MIGRAPHX_INLINE_NS
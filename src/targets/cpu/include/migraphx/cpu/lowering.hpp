@@ -2,6 +2,7 @@
 #define MIGRAPHX_GUARD_RTGLIB_CPU_LOWERING_HPP
 
 #include <migraphx/program.hpp>
+#include <migraphx/cpu/accumulate.hpp>
 #include <migraphx/config.hpp>
 
 namespace migraphx {
@@ -10,6 +11,7 @@ namespace cpu {
 
 struct lowering
 {
+    accumulate acc = accumulate::mixed;
     std::string name() const { return "cpu::lowering"; }
     void apply(program& p) const;
 };
@@ -0,0 +1,248 @@
+#ifndef MIGRAPHX_GUARD_RTGLIB_CPU_MATH_HPP
+#define MIGRAPHX_GUARD_RTGLIB_CPU_MATH_HPP
+
+#include <migraphx/cpu/vectorize.hpp>
+#include <migraphx/config.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+// Float approximations of the transcendental functions without branches or
+// library calls, so loops calling them are vectorized by the compiler. The
+// error bounds were measured against the double functions of the standard
+// library over every float in the stated range.
+
+MIGRAPHX_CPU_INLINE std::int32_t float_bits(float x)
+{
+    std::int32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+MIGRAPHX_CPU_INLINE float bits_float(std::int32_t bits)
+{
+    float x;
+    std::memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+/// The exponential, within 1 ulp. Results below the smallest normal float
+/// are flushed to zero.
+MIGRAPHX_CPU_INLINE float fast_exp(float x)
+{
+    const float hi = 88.72283905206835f;
+    const float lo = -87.33654475055310f;
+    // Round x / ln(2) to the nearest integer n, and reduce x to r = x - n * ln(2)
+    // in two steps, so r is exact
+    float y = x > hi ? hi : (x < lo ? lo : x);
+    y       = y == y ? y : 0.0f;
+    float n = (y * 1.44269504088896341f + 12582912.0f) - 12582912.0f;
+    float r = y - n * 0.693359375f;
+    r       = r + n * 2.12194440e-4f;
+    // exp(r) on [-ln(2)/2, ln(2)/2]
+    float p = 1.9875691500e-4f;
+    p       = p * r + 1.3981999507e-3f;
+    p       = p * r + 8.3334519073e-3f;
+    p       = p * r + 4.1665795894e-2f;
+    p       = p * r + 1.6666665459e-1f;
+    p       = p * r + 5.0000001201e-1f;
+    p       = p * r * r + r + 1.0f;
+    // Multiply by 2^n, in two steps since 2^128 is not a float
+    float m      = n > 127.0f ? 127.0f : n;
+    float result = p * bits_float((std::int32_t(m) + 127) << 23) * (n > m ? 2.0f : 1.0f);
+    result       = x < lo ? 0.0f : result;
+    result       = x > hi ? std::numeric_limits<float>::infinity() : result;
+    return x == x ? result : x;
+}
+
+/// exp(x) - 1, within 2 ulp, and accurate for small x where exp(x) - 1
+/// would cancel
+MIGRAPHX_CPU_INLINE float fast_expm1(float x)
+{
+    // The Taylor series up to x^9 / 9! is within 1 ulp for |x| < 1/2
+    float p = 1.0f / 362880.0f;
+    p       = p * x + 1.0f / 40320.0f;
+    p       = p * x + 1.0f / 5040.0f;
+    p       = p * x + 1.0f / 720.0f;
+    p       = p * x + 1.0f / 120.0f;
+    p       = p * x + 1.0f / 24.0f;
+    p       = p * x + 1.0f / 6.0f;
+    p       = p * x + 0.5f;
+    p       = p * x * x + x;
+    float e = fast_exp(x) - 1.0f;
+    return (x > -0.5f and x < 0.5f) ? p : e;
+}
+
+/// The natural logarithm, within 1 ulp for positive normal floats. Denormal
+/// inputs are treated as the smallest normal float, and the result for zero,
+/// negative, infinite or nan inputs is unspecified.
+MIGRAPHX_CPU_INLINE float fast_log(float x)
+{
+    // Clamp the bits to the positive normal floats, which also maps negative
+    // inputs to the smallest one
+    std::int32_t bits = float_bits(x);
+    bits              = bits < 0x00800000 ? 0x00800000 : bits;
+    bits              = bits > 0x7f7fffff ? 0x7f7fffff : bits;
+    // x = m * 2^e with m in [sqrt(1/2), sqrt(2))
+    const bool small  = (bits & 0x007fffff) < 0x003504f3;
+    std::int32_t mb   = (bits & 0x007fffff) | (small ? 0x3f800000 : 0x3f000000);
+    float e           = float((bits >> 23) - (small ? 127 : 126));
+    float m           = bits_float(mb) - 1.0f;
+    float z           = m * m;
+    float p           = 7.0376836292e-2f;
+    p                 = p * m - 1.1514610310e-1f;
+    p                 = p * m + 1.1676998740e-1f;
+    p                 = p * m - 1.2420140846e-1f;
+    p                 = p * m + 1.4249322787e-1f;
+    p                 = p * m - 1.6668057665e-1f;
+    p                 = p * m + 2.0000714765e-1f;
+    p                 = p * m - 2.4999993993e-1f;
+    p                 = p * m + 3.3333331174e-1f;
+    p                 = p * m * z;
+    p                 = p - e * 2.12194440e-4f;
+    p                 = p - 0.5f * z;
+    return (m + p) + e * 0.693359375f;
+}
+
+/// The hyperbolic tangent, within 1 ulp
+MIGRAPHX_CPU_INLINE float fast_tanh(float x)
+{
+    float a = x < 0.0f ? -x : x;
+    // An odd polynomial near zero, where 1 - 2 / (exp(2x) + 1) cancels
+    float z = x * x;
+    float p = -5.70498872745e-3f;
+    p       = p * z + 2.06390887954e-2f;
+    p       = p * z - 5.37397155531e-2f;
+    p       = p * z + 1.33314422036e-1f;
+    p       = p * z - 3.33332819422e-1f;
+    p       = p * z * x + x;
+    float t = 1.0f - 2.0f / (fast_exp(a + a) + 1.0f);
+    t       = x < 0.0f ? -t : t;
+    return a < 0.625f ? p : t;
+}
+
+/// The logistic function 1 / (1 + exp(-x)), within 2 ulp
+MIGRAPHX_CPU_INLINE float fast_sigmoid(float x) { return 1.0f / (1.0f + fast_exp(-x)); }
+
+/// The error function, within 3 ulp
+MIGRAPHX_CPU_INLINE float fast_erf(float x)
+{
+    float a = x < 0.0f ? -x : x;
+    // x * P(x^2) for |x| < 1
+    float z = x * x;
+    float p = 7.853861353153693e-5f;
+    p       = p * z - 8.010193625184903e-4f;
+    p       = p * z + 5.188327685732524e-3f;
+    p       = p * z - 2.685381193529856e-2f;
+    p       = p * z + 1.128358514861418e-1f;
+    p       = p * z - 3.761262582423300e-1f;
+    p       = p * z + 1.128379165726710e+0f;
+    p       = p * x;
+    // 1 - erfc(x) otherwise
+    float t = 1.0f / (1.0f + 0.3275911f * a);
+    float q = 1.061405429f;
+    q       = q * t - 1.453152027f;
+    q       = q * t + 1.421413741f;
+    q       = q * t - 0.284496736f;
+    q       = q * t + 0.254829592f;
+    q       = 1.0f - q * t * fast_exp(-z);
+    q       = x < 0.0f ? -q : q;
+    return a < 1.0f ? p : q;
+}
+
+// Reduce |x| to r in [-pi/4, pi/4], where |x| = r + j * pi/4 and j is even.
+// Each part of pi/4 but the last has 12 bits, so its products with j are
+// exact while j < 4096. The result is unspecified past the limit, but
+// computed without branches or overflowing conversions.
+const float sincos_limit = 2048.0f;
+
+MIGRAPHX_CPU_INLINE float sincos_reduce(float x, std::int32_t& j)
+{
+    float a = bits_float(float_bits(x) & 0x7fffffff);
+    // Round a * 2/pi to the nearest integer in the low bits of the mantissa
+    float t = a * 0.636619772367581f + 12582912.0f;
+    j       = 2 * (float_bits(t) - float_bits(12582912.0f));
+    float y = 2.0f * (t - 12582912.0f);
+    float r = a - y * 0.785400390625f;
+    r       = r + y * 2.226792275905609e-6f;
+    r       = r + y * 4.353069016360678e-10f;
+    r       = r - y * 3.111400026512001e-14f;
+    return r - y * 2.860594458229364e-18f;
+}
+
+MIGRAPHX_CPU_INLINE float sin_poly(float r, float z)
+{
+    float p = -1.9515295891e-4f;
+    p       = p * z + 8.3321608736e-3f;
+    p       = p * z - 1.6666654611e-1f;
+    return p * z * r + r;
+}
+
+MIGRAPHX_CPU_INLINE float cos_poly(float z)
+{
+    float p = 2.443315711809948e-5f;
+    p       = p * z - 1.388731625493765e-3f;
+    p       = p * z + 4.166664568298827e-2f;
+    return p * z * z - 0.5f * z + 1.0f;
+}
+
+/// The sine, within 2 ulp for |x| < 2048, and unspecified otherwise
+MIGRAPHX_CPU_INLINE float fast_sin(float x)
+{
+    std::int32_t j;
+    float r          = sincos_reduce(x, j);
+    float z          = r * r;
+    std::int32_t s   = float_bits(sin_poly(r, z));
+    std::int32_t c   = float_bits(cos_poly(z));
+    std::int32_t odd = -((j >> 1) & 1);
+    std::int32_t neg = (j << 29) ^ float_bits(x);
+    return bits_float(((c & odd) | (s & ~odd)) ^ (neg & std::int32_t(0x80000000)));
+}
+
+/// The cosine, within 2 ulp for |x| < 2048, and unspecified otherwise
+MIGRAPHX_CPU_INLINE float fast_cos(float x)
+{
+    std::int32_t j;
+    float r          = sincos_reduce(x, j);
+    float z          = r * r;
+    std::int32_t s   = float_bits(sin_poly(r, z));
+    std::int32_t c   = float_bits(cos_poly(z));
+    std::int32_t odd = -((j >> 1) & 1);
+    std::int32_t neg = (j + 2) << 29;
+    return bits_float(((s & odd) | (c & ~odd)) ^ (neg & std::int32_t(0x80000000)));
+}
+
+// The functions above applied to `n` floats, compiled for each instruction
+// set. The input and the output must not overlap.
+
+void vector_exp(const float* x, float* y, std::size_t n);
+
+/// Inputs outside the range of `fast_log` are computed with `std::log`
+void vector_log(const float* x, float* y, std::size_t n);
+
+void vector_tanh(const float* x, float* y, std::size_t n);
+
+void vector_sigmoid(const float* x, float* y, std::size_t n);
+
+void vector_erf(const float* x, float* y, std::size_t n);
+
+/// Inputs outside the range of `fast_sin` are computed with `std::sin`
+void vector_sin(const float* x, float* y, std::size_t n);
+
+/// Inputs outside the range of `fast_cos` are computed with `std::cos`
+void vector_cos(const float* x, float* y, std::size_t n);
+
+/// `x > 0 ? x : alpha * (exp(x) - 1)`
+void vector_elu(const float* x, float* y, std::size_t n, float alpha);
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
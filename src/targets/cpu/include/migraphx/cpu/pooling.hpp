@@ -0,0 +1,76 @@
+#ifndef MIGRAPHX_GUARD_RTGLIB_CPU_POOLING_HPP
+#define MIGRAPHX_GUARD_RTGLIB_CPU_POOLING_HPP
+
+#include <migraphx/argument.hpp>
+#include <migraphx/op/pooling.hpp>
+#include <migraphx/cpu/accumulate.hpp>
+#include <migraphx/config.hpp>
+#include <algorithm>
+#include <limits>
+#include <string>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+struct max_pool
+{
+    static std::string name() { return "max"; }
+
+    template <class T>
+    static T start()
+    {
+        return std::numeric_limits<T>::lowest();
+    }
+
+    template <class T>
+    static T apply(T x, T y)
+    {
+        return std::max(x, y);
+    }
+
+    template <class T>
+    static T final(T x, std::size_t)
+    {
+        return x;
+    }
+};
+
+struct avg_pool
+{
+    static std::string name() { return "average"; }
+
+    template <class T>
+    static T start()
+    {
+        return T(0);
+    }
+
+    template <class T>
+    static T apply(T x, T y)
+    {
+        return x + y;
+    }
+
+    template <class T>
+    static T final(T x, std::size_t n)
+    {
+        return x / T(n);
+    }
+};
+
+/// Pool a standard NCHW input with a kernel specialized for the window. Global pooling reduces
+/// each channel plane, 2x2 and 3x3 windows with a stride of 2 are unrolled, and other windows
+/// are reduced along the rows and then along the columns. Returns false, without writing the
+/// result, when the input is not standard.
+template <class Op>
+bool specialized_pooling(const argument& result,
+                         const argument& input,
+                         const op::pooling& op,
+                         accumulate acc);
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef MIGRAPHX_GUARD_RTGLIB_CPU_PREALLOCATE_MEMORY_HPP
+#define MIGRAPHX_GUARD_RTGLIB_CPU_PREALLOCATE_MEMORY_HPP
+
+#include <migraphx/program.hpp>
+#include <migraphx/cpu/context.hpp>
+#include <migraphx/config.hpp>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+/**
+ * Bind the memory parameters created by `memory_coloring` and `eliminate_allocation` to buffers
+ * owned by the context, so that every eval reuses the same memory. The output parameter is
+ * replaced by an allocation so results stay valid after the next eval.
+ */
+struct preallocate_memory
+{
+    context* ctx = nullptr;
+    std::string name() const { return "cpu::preallocate_memory"; }
+    void apply(program& p) const;
+};
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
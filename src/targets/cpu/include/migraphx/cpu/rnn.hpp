@@ -0,0 +1,47 @@
+#ifndef MIGRAPHX_GUARD_RTGLIB_CPU_RNN_HPP
+#define MIGRAPHX_GUARD_RTGLIB_CPU_RNN_HPP
+
+#include <migraphx/argument.hpp>
+#include <migraphx/cpu/accumulate.hpp>
+#include <migraphx/op/rnn.hpp>
+#include <migraphx/op/gru.hpp>
+#include <migraphx/op/lstm.hpp>
+#include <migraphx/config.hpp>
+#include <vector>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+// The recurrent operators compute the input projections of every step with one gemm, and then
+// only multiply the previous hidden state per step, with the gates fused into one pass. The
+// hidden state of each step is written to its place in the result, which is read back as the
+// state of the next step. The arguments are standard, and the optional ones have been replaced
+// by zeros. The activation functions are listed for each direction. Half values are computed in
+// float.
+
+/// Compute a vanilla rnn from the sequence, w, r, bias and initial hidden state
+void rnn(const argument& result,
+         const std::vector<argument>& args,
+         const op::rnn& op,
+         accumulate acc);
+
+/// Compute a gru from the sequence, w, r, bias and initial hidden state
+void gru(const argument& result,
+         const std::vector<argument>& args,
+         const op::gru& op,
+         accumulate acc);
+
+/// Compute an lstm from the sequence, w, r, bias, initial hidden state, initial cell state and
+/// peephole weights. The cell state of the last step of each direction is written to `cell`.
+void lstm(const argument& result,
+          const argument& cell,
+          const std::vector<argument>& args,
+          const op::lstm& op,
+          accumulate acc);
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef MIGRAPHX_GUARD_RTGLIB_CPU_SOFTMAX_HPP
+#define MIGRAPHX_GUARD_RTGLIB_CPU_SOFTMAX_HPP
+
+#include <migraphx/argument.hpp>
+#include <migraphx/config.hpp>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+/// Compute the softmax of a standard argument along `axis`. Contiguous rows are normalized one
+/// after the other, and other axes are normalized for a block of positions at a time, so the
+/// input is always read with unit stride. Float values use `fast_exp`, and half values are
+/// computed in float.
+void softmax(const argument& result, const argument& input, std::size_t axis);
+
+/// Compute the log of the softmax of a standard argument over the dimensions from `axis` to the
+/// last one
+void logsoftmax(const argument& result, const argument& input, std::size_t axis);
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <migraphx/program.hpp>
 #include <migraphx/cpu/context.hpp>
+#include <migraphx/cpu/accumulate.hpp>
 #include <migraphx/config.hpp>
 
 namespace migraphx {
@@ -12,6 +13,8 @@ namespace cpu {
 
 struct target
 {
+    accumulate acc = accumulate::mixed;
+
     std::string name() const;
     std::vector<pass> get_passes(migraphx::context& ctx) const;
     migraphx::context get_context() const { return context{}; }
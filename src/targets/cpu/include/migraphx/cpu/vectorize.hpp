@@ -0,0 +1,17 @@
+#ifndef MIGRAPHX_GUARD_RTGLIB_CPU_VECTORIZE_HPP
+#define MIGRAPHX_GUARD_RTGLIB_CPU_VECTORIZE_HPP
+
+// Build a kernel for several instruction sets and pick one when the library
+// is loaded. The kernel itself should be a non-template function, which can
+// call templates marked with MIGRAPHX_CPU_INLINE so they are compiled for
+// each instruction set as well.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define MIGRAPHX_CPU_TARGETS \
+    __attribute__((target_clones("arch=skylake-avx512", "arch=haswell", "default")))
+#define MIGRAPHX_CPU_INLINE __attribute__((always_inline)) inline
+#else
+#define MIGRAPHX_CPU_TARGETS
+#define MIGRAPHX_CPU_INLINE inline
+#endif
+
+#endif
@@ -6,7 +6,23 @@
 #include <migraphx/shape_for_each.hpp>
 #include <migraphx/iterator_for.hpp>
 #include <migraphx/par_dfor.hpp>
+#include <migraphx/par_for.hpp>
+#include <migraphx/par_shape_for_each.hpp>
+#include <migraphx/rank.hpp>
+#include <migraphx/rewrite_rnn.hpp>
 #include <migraphx/cpu/gemm.hpp>
+#include <migraphx/cpu/batch_norm.hpp>
+#include <migraphx/cpu/pooling.hpp>
+#include <migraphx/cpu/allocate.hpp>
+#include <migraphx/cpu/concat.hpp>
+#include <migraphx/cpu/convert.hpp>
+#include <migraphx/cpu/softmax.hpp>
+#include <migraphx/cpu/math.hpp>
+#include <migraphx/cpu/rnn.hpp>
+#include <migraphx/serialize.hpp>
+#include <array>
+#include <cmath>
+#include <numeric>
 #include <unordered_map>
 #include <utility>
 
@@ -33,116 +49,168 @@ typename std::conditional_t<std::is_integral<T>{}, std::make_signed<T>, std::ena
 //
 // inputs are:
 // args[0] -> input data buffer
-// args[1] -> mini batch mean
-// args[2] -> mini batch variance
-// args[3] -> gamma
-// args[4] -> bias
+// args[1] -> gamma
+// args[2] -> bias
+// args[3] -> mini batch mean
+// args[4] -> mini batch variance
 //
 // The equation to compute batch norm for inference is:
 //
-// output[i] = bias + gamma * (input[i] + mean) / sqrt(variance + epsilon)
+// output[i] = bias + gamma * (input[i] - mean) / sqrt(variance + epsilon)
 //
-// the input data format should be nchw
+// which is computed as input[i] * scale + shift. The input data format can
+// be nchw or nhwc.
 //
 struct cpu_batch_norm_inference
 {
     op::batch_norm_inference op;
 
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return migraphx::reflect(self.op, f);
+    }
+
     std::string name() const { return "cpu::batch_norm_inference"; }
 
-    shape compute_shape(const std::vector<shape>& inputs) const { return op.compute_shape(inputs); }
+    shape compute_shape(std::vector<shape> inputs) const
+    {
+        inputs.pop_back();
+        return op.compute_shape(inputs);
+    }
 
     argument compute(context&, const shape& output_shape, std::vector<argument> args) const
     {
-        argument output{output_shape};
-
-        double epsilon           = op.epsilon;
-        auto input               = args[0];
-        auto arg_gamma           = args[1];
-        auto arg_bias            = args[2];
-        auto mini_batch_mean     = args[3];
-        auto mini_batch_variance = args[4];
-
-        auto num_batch    = output_shape.lens()[0];
-        auto num_channels = output_shape.lens()[1];
-        auto image_height = output_shape.lens()[2];
-        auto image_width  = output_shape.lens()[3];
-
-        if(op.bn_mode == op::batch_norm_inference::spatial)
-        {
-            visit_all(output, input, mini_batch_mean, mini_batch_variance, arg_gamma, arg_bias)(
-                [&](auto result, auto buffer, auto mean, auto variance, auto gamma, auto bias) {
-
-                    par_dfor(num_batch, num_channels, image_height, image_width)(
-                        [&](std::size_t n, std::size_t c, std::size_t h, std::size_t w) {
-                            assert((variance[c] + epsilon) > 0);
-                            result(n, c, h, w) = gamma[c] * (buffer(n, c, h, w) - mean[c]) /
-                                                     std::sqrt(variance[c] + epsilon) +
-                                                 bias[c];
-                        });
-                });
-        }
-
-        if(op.bn_mode == op::batch_norm_inference::per_activation)
-        {
-            visit_all(output, input, mini_batch_mean, mini_batch_mean, arg_gamma, arg_bias)(
-                [&](auto result, auto buffer, auto mean, auto variance, auto gamma, auto bias) {
-
-                    par_dfor(num_batch, num_channels, image_height, image_width)(
-                        [&](std::size_t n, std::size_t c, std::size_t h, std::size_t w) {
-                            assert((variance(c, h, w) + epsilon) > 0);
-                            result(n, c, h, w) = gamma(c, h, w) *
-                                                     (buffer(n, c, h, w) - mean(c, h, w)) /
-                                                     std::sqrt(variance(c, h, w) + epsilon) +
-                                                 bias(c, h, w);
-                        });
-                });
-        }
-
+        argument output = args.back();
+        // Fold the statistics into a scale and a shift once, instead of a
+        // sqrt and a divide for each element
+        shape ss{output_shape.type(), {args[1].get_shape().elements()}};
+        argument scale{ss};
+        argument shift{ss};
+        visit_all(scale, shift, args[1], args[2], args[3], args[4])(
+            [&](auto s, auto t, auto gamma, auto bias, auto mean, auto variance) {
+                for(std::size_t i = 0; i < ss.elements(); i++)
+                {
+                    assert((variance[i] + op.epsilon) > 0);
+                    double r = 1.0 / std::sqrt(double(variance[i]) + op.epsilon);
+                    s[i]     = gamma[i] * r;
+                    t[i]     = bias[i] - mean[i] * gamma[i] * r;
+                }
+            });
+        scale_shift(output, args[0], scale, shift);
         return output;
     }
+
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
+    {
+        return shapes.size() - 1;
+    }
 };
 
+// Call `f` with a function computing pow(x, -beta), using square roots for
+// the common values of beta
+template <class F>
+void visit_lrn_pow(float beta, F f)
+{
+    if(beta == 0.75f)
+        f([](float x) { return 1.0f / (std::sqrt(x) * std::sqrt(std::sqrt(x))); });
+    else if(beta == 0.5f)
+        f([](float x) { return 1.0f / std::sqrt(x); });
+    else if(beta == 1.0f)
+        f([](float x) { return 1.0f / x; });
+    else
+        f([=](float x) { return std::pow(x, -beta); });
+}
+
 struct cpu_lrn
 {
     op::lrn op;
 
+    // Number of pixels whose window sums are kept while sliding across the
+    // channels
+    static constexpr std::size_t tile = 256;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return migraphx::reflect(self.op, f);
+    }
+
     std::string name() const { return "cpu::lrn"; }
-    shape compute_shape(const std::vector<shape>& inputs) const { return op.compute_shape(inputs); }
+    shape compute_shape(std::vector<shape> inputs) const
+    {
+        inputs.pop_back();
+        // The channels are read as planes of contiguous pixels
+        check_shapes{inputs, *this}.has(1).standard();
+        if(inputs.front().lens().size() < 2)
+            MIGRAPHX_THROW("LRN: Expected an input with channels");
+        if(op.size < 1)
+            MIGRAPHX_THROW("LRN: Size must be positive");
+        return op.compute_shape(inputs);
+    }
     argument compute(context&, shape output_shape, std::vector<argument> args) const
     {
-        argument result{output_shape};
+        argument result = args.back();
         visit_all(result, args[0])([&](auto output, auto input) {
-            int n_batch         = output_shape.lens()[0];
-            int channels        = output_shape.lens()[1];
-            int height          = output_shape.lens()[2];
-            int width           = output_shape.lens()[3];
-            float alphaoverarea = op.alpha / float(op.size);
-            int radius          = (op.size - 1) / 2;
-
-            par_dfor(n_batch, height, width)([&](int b, int h, int w) {
-                float scale = 0;
-                dfor(channels)([&](int c) {
-                    auto start = (c - radius) < 0 ? 0 : (c - radius);
-                    auto end   = (c + radius) > channels ? channels : (c + radius);
-                    for(auto k = start; k < end; ++k)
+            using type                 = typename decltype(output)::value_type;
+            const std::size_t n_batch  = output_shape.lens()[0];
+            const std::size_t channels = output_shape.lens()[1];
+            const std::size_t spatial  = output_shape.elements() / (n_batch * channels);
+            const std::size_t tiles    = (spatial + tile - 1) / tile;
+            // The window of channel c is [c - lower, c + upper]
+            const std::size_t lower    = (op.size - 1) / 2;
+            const std::size_t upper    = op.size - 1 - lower;
+            const float alphaoverarea  = op.alpha / float(op.size);
+            visit_lrn_pow(op.beta, [&](auto pow_beta) {
+                par_for(n_batch * tiles, 1, [&](std::size_t i) {
+                    const std::size_t offset =
+                        (i / tiles) * channels * spatial + (i % tiles) * tile;
+                    const std::size_t len = std::min(tile, spatial - (i % tiles) * tile);
+                    const type* x         = input.data() + offset;
+                    type* y               = output.data() + offset;
+                    // Sums of squares, in double so the subtractions do not
+                    // build up rounding errors across the channels
+                    std::array<double, tile> sum{};
+                    auto accumulate = [&](std::size_t c, double sign) {
+                        const type* xc = x + c * spatial;
+                        for(std::size_t j = 0; j < len; j++)
+                            sum[j] += sign * double(xc[j]) * double(xc[j]);
+                    };
+                    for(std::size_t c = 0; c < std::min(upper, channels); c++)
+                        accumulate(c, 1);
+                    for(std::size_t c = 0; c < channels; c++)
                     {
-                        scale += std::pow(input(b, k, h, w), 2);
+                        if(c + upper < channels)
+                            accumulate(c + upper, 1);
+                        const type* xc = x + c * spatial;
+                        type* yc       = y + c * spatial;
+                        for(std::size_t j = 0; j < len; j++)
+                            yc[j] = float(xc[j]) *
+                                    pow_beta(op.bias + alphaoverarea * float(sum[j]));
+                        if(c >= lower)
+                            accumulate(c - lower, -1);
                     }
-                    scale *= alphaoverarea;
-                    scale += op.bias;
-                    scale              = std::pow(scale, -op.beta);
-                    output(b, c, h, w) = input(b, c, h, w) * scale;
                 });
             });
         });
         return result;
     }
+
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
+    {
+        return shapes.size() - 1;
+    }
 };
 
 struct clip_op
 {
     op::clip op;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return migraphx::reflect(self.op, f);
+    }
     std::string name() const { return "cpu::clip"; }
     auto fcn() const
     {
@@ -158,16 +226,28 @@ struct clip_op
 struct cpu_convolution
 {
     op::convolution op;
+    accumulate acc = accumulate::mixed;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return pack_join(migraphx::reflect(self.op, f), pack(f(self.acc, "accumulate")));
+    }
 
     std::string name() const { return "cpu::convolution"; }
-    shape compute_shape(const std::vector<shape>& inputs) const { return op.compute_shape(inputs); }
+    shape compute_shape(std::vector<shape> inputs) const
+    {
+        inputs.pop_back();
+        return op.compute_shape(inputs);
+    }
     argument compute(context&, shape output_shape, std::vector<argument> args) const
     {
-        argument result{output_shape};
+        argument result = args.back();
         visit_all(result, args[0], args[1])([&](auto output, auto input, auto weights) {
-            auto in   = input.get_shape().lens();
-            auto in_h = in[2];
-            auto in_w = in[3];
+            using type = typename decltype(output)::value_type;
+            auto in    = input.get_shape().lens();
+            auto in_h  = in[2];
+            auto in_w  = in[3];
 
             auto wei   = weights.get_shape().lens();
             auto wei_n = wei[0];
@@ -175,30 +255,231 @@ struct cpu_convolution
             auto wei_h = wei[2];
             auto wei_w = wei[3];
 
-            par_dfor(output_shape.lens()[0],
-                     output_shape.lens()[1],
-                     output_shape.lens()[2],
-                     output_shape.lens()[3])(
-                [&](std::size_t o, std::size_t w, std::size_t i, std::size_t j) {
-                    const auto start_x  = i * op.stride[0] - op.padding[0];
-                    const auto start_y  = j * op.stride[1] - op.padding[1];
-                    const auto group_id = w / (wei_n / op.group);
-
-                    double acc = 0;
-                    dfor(wei_c, wei_h, wei_w)([&](std::size_t k, std::size_t x, std::size_t y) {
-                        const auto in_x  = start_x + x;
-                        const auto in_y  = start_y + y;
-                        const auto in_ch = group_id * wei_c + k;
-                        if(in_x >= 0 && in_x < in_h && in_y >= 0 && in_y < in_w)
+            visit_accumulator<type>(acc, [&](auto zero) {
+                using acc_type = decltype(zero);
+                par_dfor(output_shape.lens()[0],
+                         output_shape.lens()[1],
+                         output_shape.lens()[2],
+                         output_shape.lens()[3])(
+                    [&](std::size_t o, std::size_t w, std::size_t i, std::size_t j) {
+                        const auto start_x  = i * op.stride[0] - op.padding[0];
+                        const auto start_y  = j * op.stride[1] - op.padding[1];
+                        const auto group_id = w / (wei_n / op.group);
+
+                        acc_type sum = zero;
+                        dfor(wei_c, wei_h, wei_w)(
+                            [&](std::size_t k, std::size_t x, std::size_t y) {
+                                const auto in_x  = start_x + x * op.dilation[0];
+                                const auto in_y  = start_y + y * op.dilation[1];
+                                const auto in_ch = group_id * wei_c + k;
+                                if(in_x >= 0 && in_x < in_h && in_y >= 0 && in_y < in_w)
+                                {
+                                    sum += acc_type(input(o, in_ch, in_x, in_y)) *
+                                           acc_type(weights(w, k, x, y));
+                                }
+                            });
+                        output(o, w, i, j) = sum;
+                    });
+            });
+        });
+        return result;
+    }
+
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
+    {
+        return shapes.size() - 1;
+    }
+};
+
+//
+// convolution computed as a matrix multiply
+//
+// inputs are:
+// args[0] -> input data buffer
+// args[1] -> weights
+// args[2] -> workspace for the patches of one image
+// args[3] -> output buffer
+//
+// The patches of each image are packed into the workspace as a
+// (channels * kernel_h * kernel_w) x (output_h * output_w) matrix which is
+// then multiplied by the weights of each group. A 1x1 kernel with no
+// stride or padding multiplies the input directly, and needs no workspace.
+// The quantized convolution packs int8 patches and accumulates in int32.
+// Literal float weights are packed for the gemm kernel when the program is
+// compiled, and `packed` is then the shape of the weights before packing.
+//
+template <class Op>
+struct cpu_gemm_convolution
+{
+    Op op;
+    accumulate acc = accumulate::mixed;
+    shape packed{};
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return pack_join(migraphx::reflect(self.op, f),
+                         pack(f(self.acc, "accumulate"), f(self.packed, "packed")));
+    }
+
+    bool is_packed() const { return not packed.lens().empty(); }
+
+    std::string name() const { return "cpu::gemm_" + op.name(); }
+
+    static constexpr bool quantized() { return std::is_same<Op, op::quant_convolution>{}; }
+
+    static bool is_pointwise(const Op& op, const shape& weights)
+    {
+        auto&& wei = weights.lens();
+        return wei[2] == 1 and wei[3] == 1 and op.stride[0] == 1 and op.stride[1] == 1 and
+               op.padding[0] == 0 and op.padding[1] == 0;
+    }
+
+    static bool is_supported_type(shape::type_t t)
+    {
+        if(quantized())
+            return t == shape::int8_type;
+        return t == shape::float_type or t == shape::half_type;
+    }
+
+    // Only the layouts and types that can be passed to the fast gemm are
+    // supported, everything else uses cpu_convolution. Half values are
+    // converted to float.
+    static bool is_supported(const std::vector<shape>& inputs)
+    {
+        return inputs.size() == 2 and inputs[0].type() == inputs[1].type() and
+               std::all_of(inputs.begin(), inputs.end(), [](const shape& s) {
+                   return is_supported_type(s.type()) and s.lens().size() == 4 and s.standard();
+               });
+    }
+
+    static shape
+    workspace_shape(const Op& op, const std::vector<shape>& inputs, const shape& output)
+    {
+        auto&& in  = inputs.at(0).lens();
+        auto&& wei = inputs.at(1).lens();
+        auto&& out = output.lens();
+        auto t     = quantized() ? shape::int8_type : shape::float_type;
+        if(is_pointwise(op, inputs.at(1)))
+            return {t, {0}};
+        return {t, {in[1] * wei[2] * wei[3], out[2] * out[3]}};
+    }
+
+    shape compute_shape(const std::vector<shape>& inputs) const
+    {
+        check_shapes{inputs, *this}.has(4).standard();
+        return op.compute_shape({inputs.at(0), is_packed() ? packed : inputs.at(1)});
+    }
+
+    // Pack the weights of each group for the gemm kernel
+    static argument pack_weights(const Op& op, const argument& weights, accumulate acc)
+    {
+        const auto& s  = weights.get_shape();
+        auto&& wei     = s.lens();
+        const auto rows = wei[0] / op.group;
+        const auto cols = wei[1] * wei[2] * wei[3];
+        argument groups{shape{s.type(), {std::size_t(op.group), rows, cols}}, weights.data};
+        return pack_gemm_operand(groups, gemm_operand::a, acc);
+    }
+
+    argument compute(context& ctx, const shape& output_shape, std::vector<argument> args) const
+    {
+        argument result = args.back();
+        if(output_shape.type() == shape::half_type)
+        {
+            // Compute in float, converting the half values in bulk
+            args[0] = to_float(args[0]);
+            if(not is_packed())
+                args[1] = to_float(args[1]);
+            args.back() = argument{shape{shape::float_type, output_shape.lens()}};
+            from_float(result, compute(ctx, args.back().get_shape(), args));
+            return result;
+        }
+        const auto& weights = args[1];
+        visit_all(args[0], args[2])([&](auto input, auto workspace) {
+            auto in  = input.get_shape().lens();
+            auto wei = is_packed() ? packed.lens() : weights.get_shape().lens();
+            auto out = output_shape.lens();
+
+            const std::size_t group_out  = wei[0] / op.group;
+            const std::size_t group_k    = wei[1] * wei[2] * wei[3];
+            const std::size_t out_size   = out[2] * out[3];
+            const std::size_t image_size = in[1] * in[2] * in[3];
+            const bool pointwise = is_pointwise(op, is_packed() ? packed : weights.get_shape());
+
+            // The output of the quantized convolution is int32
+            auto make_matrix =
+                [&](shape::type_t t, auto* data, std::size_t rows, std::size_t cols) {
+                    return argument{shape{t, {rows, cols}}, data};
+                };
+            const auto in_type = input.get_shape().type();
+
+            for(std::size_t n = 0; n < out[0]; n++)
+            {
+                auto* image = input.data() + n * image_size;
+                auto* col   = pointwise ? image : workspace.data();
+                if(not pointwise)
+                {
+                    // Each row of the workspace is one tap of the kernel for one channel
+                    par_for(in[1] * wei[2] * wei[3], [&](std::size_t row) {
+                        const auto c  = row / (wei[2] * wei[3]);
+                        const auto kh = (row / wei[3]) % wei[2];
+                        const auto kw = row % wei[3];
+                        auto* dst     = col + row * out_size;
+                        for(std::size_t i = 0; i < out[2]; i++)
                         {
-                            acc += input(o, in_ch, in_x, in_y) * weights(w, k, x, y);
+                            const auto in_x = std::ptrdiff_t(i * op.stride[0] +
+                                                             kh * op.dilation[0]) -
+                                              std::ptrdiff_t(op.padding[0]);
+                            for(std::size_t j = 0; j < out[3]; j++)
+                            {
+                                const auto in_y = std::ptrdiff_t(j * op.stride[1] +
+                                                                 kw * op.dilation[1]) -
+                                                  std::ptrdiff_t(op.padding[1]);
+                                const bool inside = in_x >= 0 and in_x < in[2] and
+                                                    in_y >= 0 and in_y < in[3];
+                                *dst++ = inside ? image[(c * in[2] + in_x) * in[3] + in_y] : 0;
+                            }
                         }
                     });
-                    output(o, w, i, j) = acc;
-                });
+                }
+                for(std::size_t g = 0; g < op.group; g++)
+                {
+                    const std::size_t offset = (n * wei[0] + g * group_out) * out_size;
+
+                    auto b = make_matrix(in_type, col + g * group_k * out_size, group_k, out_size);
+                    auto c = make_matrix(output_shape.type(),
+                                         result.data() + offset * output_shape.type_size(),
+                                         group_out,
+                                         out_size);
+                    if(is_packed())
+                    {
+                        // The panels of each group are packed one after the other
+                        const auto& ps  = weights.get_shape();
+                        const auto size = ps.elements() / op.group;
+                        argument a{shape{ps.type(), {size}},
+                                   weights.data() + g * size * ps.type_size()};
+                        migemm_packed(c, a, b, gemm_operand::a, 1.0f, 0.0f, acc);
+                    }
+                    else
+                    {
+                        const auto type_size = weights.get_shape().type_size();
+                        auto a               = make_matrix(in_type,
+                                             weights.data() + g * group_out * group_k * type_size,
+                                             group_out,
+                                             group_k);
+                        migemm(c, a, b, 1.0f, 0.0f, acc);
+                    }
+                }
+            }
         });
         return result;
     }
+
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
+    {
+        return shapes.size() - 1;
+    }
 };
 
 struct cpu_im2col
@@ -206,11 +487,15 @@ struct cpu_im2col
     op::im2col op;
 
     static std::string name() { return "cpu::im2col"; }
-    shape compute_shape(const std::vector<shape>& inputs) const { return op.compute_shape(inputs); }
+    shape compute_shape(std::vector<shape> inputs) const
+    {
+        inputs.pop_back();
+        return op.compute_shape(inputs);
+    }
 
-    argument compute(context&, const shape& output_shape, std::vector<argument> args) const
+    argument compute(context&, const shape&, std::vector<argument> args) const
     {
-        argument result{output_shape};
+        argument result = args.back();
         auto input_shape   = args[0].get_shape();
         auto weights_shape = args[1].get_shape();
         visit_all(result, args[0])([&](auto col, auto input) {
@@ -255,135 +540,173 @@ struct cpu_im2col
         });
         return result;
     }
-};
-
-struct max_pool
-{
-    static std::string name() { return "max"; }
-    static double start() { return std::numeric_limits<double>::lowest(); }
 
-    static double apply(double x, double y)
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
     {
-        double m = std::max(x, y);
-        return (m);
+        return shapes.size() - 1;
     }
-
-    static double final(double x, double) { return (x); }
-};
-
-struct avg_pool
-{
-    static std::string name() { return "average"; }
-    static double start() { return 0.0; }
-
-    static double apply(double x, double y) { return x + y; }
-
-    static double final(double x, double y) { return x / y; }
 };
 
 template <class Op>
 struct cpu_pooling
 {
     op::pooling op;
+    accumulate acc = accumulate::mixed;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return pack_join(migraphx::reflect(self.op, f), pack(f(self.acc, "accumulate")));
+    }
 
     std::string name() const { return "cpu::pooling_" + Op::name(); }
-    shape compute_shape(const std::vector<shape>& inputs) const { return op.compute_shape(inputs); }
+    shape compute_shape(std::vector<shape> inputs) const
+    {
+        inputs.pop_back();
+        return op.compute_shape(inputs);
+    }
     argument compute(context&, const shape& output_shape, std::vector<argument> args) const
     {
-        argument result{output_shape};
+        argument result = args.back();
+        if(specialized_pooling<Op>(result, args[0], op, acc))
+            return result;
         visit_all(result, args[0])([&](auto output, auto input) {
             using type = typename decltype(output)::value_type;
             auto in_h  = input.get_shape().lens()[2];
             auto in_w  = input.get_shape().lens()[3];
 
-            par_dfor(output_shape.lens()[0],
-                     output_shape.lens()[1],
-                     output_shape.lens()[2],
-                     output_shape.lens()[3])(
-                [&](std::size_t o, std::size_t w, std::size_t i, std::size_t j) {
-                    const int start_x0 = i * op.stride[0] - op.padding[0];
-                    const int start_y0 = j * op.stride[1] - op.padding[1];
-
-                    const int hend = std::min(start_x0 + op.lengths[0], in_h);
-                    const int wend = std::min(start_y0 + op.lengths[1], in_w);
-
-                    const int start_x = std::max(start_x0, 0);
-                    const int start_y = std::max(start_y0, 0);
-
-                    const int w_h       = (hend - start_x);
-                    const int w_w       = (wend - start_y);
-                    const int pool_size = std::max(w_h * w_w, 1);
-
-                    double acc = Op::start();
-                    dfor(w_h, w_w)([&](int x, int y) {
-                        const int in_x = start_x + x;
-                        const int in_y = start_y + y;
-                        if(in_x >= 0 && in_x < in_h && in_y >= 0 && in_y < in_w)
-                        {
-                            acc = Op::apply(acc, input(o, w, in_x, in_y));
-                        }
+            visit_accumulator<type>(acc, [&](auto zero) {
+                using acc_type = decltype(zero);
+                par_dfor(output_shape.lens()[0],
+                         output_shape.lens()[1],
+                         output_shape.lens()[2],
+                         output_shape.lens()[3])(
+                    [&](std::size_t o, std::size_t w, std::size_t i, std::size_t j) {
+                        const int start_x0 = i * op.stride[0] - op.padding[0];
+                        const int start_y0 = j * op.stride[1] - op.padding[1];
+
+                        const int hend = std::min(start_x0 + op.lengths[0], in_h);
+                        const int wend = std::min(start_y0 + op.lengths[1], in_w);
+
+                        const int start_x = std::max(start_x0, 0);
+                        const int start_y = std::max(start_y0, 0);
+
+                        const int w_h       = (hend - start_x);
+                        const int w_w       = (wend - start_y);
+                        const int pool_size = std::max(w_h * w_w, 1);
+
+                        // The window is already clipped to the input
+                        auto r = Op::template start<acc_type>();
+                        dfor(w_h, w_w)([&](int x, int y) {
+                            r = Op::apply(r, acc_type(input(o, w, start_x + x, start_y + y)));
+                        });
+                        output(o, w, i, j) = type(Op::final(r, pool_size));
                     });
-                    output(o, w, i, j) = type(Op::final(acc, pool_size));
-                });
+            });
         });
         return result;
     }
+
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
+    {
+        return shapes.size() - 1;
+    }
 };
 
 struct cpu_contiguous
 {
     op::contiguous op;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return migraphx::reflect(self.op, f);
+    }
     std::string name() const { return "cpu::contiguous"; }
-    shape compute_shape(const std::vector<shape>& inputs) const { return op.compute_shape(inputs); }
-    argument compute(context&, const shape& output_shape, std::vector<argument> args) const
+    shape compute_shape(std::vector<shape> inputs) const
     {
-        return op.compute(output_shape, std::move(args));
+        inputs.pop_back();
+        return op.compute_shape(inputs);
+    }
+    argument compute(context&, const shape&, std::vector<argument> args) const
+    {
+        argument result = args.back();
+        assert(result.get_shape().standard());
+        visit_all(result, args[0])([&](auto output, auto input) {
+            par_for_each_offset(output.get_shape(), input.get_shape())(
+                [&](auto i, auto j) { output.data()[i] = input.data()[j]; });
+        });
+        return result;
+    }
+
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
+    {
+        return shapes.size() - 1;
     }
 };
 
 struct cpu_pad
 {
     op::pad op;
-    std::string name() const { return "cpu::contiguous"; }
-    shape compute_shape(const std::vector<shape>& inputs) const { return op.compute_shape(inputs); }
-    argument compute(context&, const shape& output_shape, std::vector<argument> args) const
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return migraphx::reflect(self.op, f);
+    }
+    std::string name() const { return "cpu::pad"; }
+    shape compute_shape(std::vector<shape> inputs) const
+    {
+        inputs.pop_back();
+        return op.compute_shape(inputs);
+    }
+    argument compute(context&, const shape&, std::vector<argument> args) const
     {
-        assert(output_shape.standard());
-        argument result{output_shape};
+        argument result = args.back();
+        assert(result.get_shape().standard());
         result.visit([&](auto output) { std::fill(output.begin(), output.end(), op.value); });
 
         visit_all(result, args[0])([&](auto output, auto input) {
-            shape_for_each(input.get_shape(), [&](const auto& idx) {
-                std::vector<std::size_t> new_idx(idx.size());
-                std::transform(
-                    idx.begin(), idx.end(), op.pads.begin(), new_idx.begin(), [](auto i, auto j) {
-                        return i + j;
-                    });
-                output(new_idx.begin(), new_idx.end()) = input(idx.begin(), idx.end());
-            });
+            // View the region of the output that the input is copied to
+            const auto& out_strides = output.get_shape().strides();
+            shape window{output.get_shape().type(), input.get_shape().lens(), out_strides};
+            auto* start = output.data() + std::inner_product(out_strides.begin(),
+                                                             out_strides.end(),
+                                                             op.pads.begin(),
+                                                             std::size_t{0});
+            par_for_each_offset(window, input.get_shape())(
+                [&](auto i, auto j) { start[i] = input.data()[j]; });
         });
 
         return result;
     }
-};
 
-struct cpu_concat
-{
-    op::concat op;
-    std::string name() const { return "cpu::concat"; }
-    shape compute_shape(const std::vector<shape>& inputs) const { return op.compute_shape(inputs); }
-    argument compute(context&, const shape& output_shape, std::vector<argument> args) const
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
     {
-        return op.compute(output_shape, std::move(args));
+        return shapes.size() - 1;
     }
 };
 
+// When B is a literal it is packed for the gemm kernel when the program is
+// compiled, and `packed_b` is then the shape of B before packing.
 struct cpu_gemm
 {
     op::dot op;
+    accumulate acc = accumulate::mixed;
+    shape packed_b{};
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return pack_join(migraphx::reflect(self.op, f),
+                         pack(f(self.acc, "accumulate"), f(self.packed_b, "packed_b")));
+    }
     std::string name() const { return "cpu::dot"; }
-    shape compute_shape(const std::vector<shape>& inputs) const
+    shape compute_shape(std::vector<shape> inputs) const
     {
+        inputs.pop_back();
+        if(is_packed())
+            inputs[1] = packed_b;
         if(inputs.size() == 3)
         {
             auto c_shape = inputs.at(2);
@@ -392,12 +715,12 @@ struct cpu_gemm
         return op.compute_shape(inputs);
     }
 
-    argument compute(context&, const shape& output_shape, std::vector<argument> args) const
+    argument compute(context&, const shape&, std::vector<argument> args) const
     {
-        argument result{output_shape};
+        argument result = args.back();
         // 3 inputs, it is alpha * A * B + beta * C, then
         // A and B are matrics, and C is broadcastable to A * B
-        if(args.size() == 3)
+        if(args.size() == 4)
         {
             // no need to consider the value of args[2]
             if(op.beta == 0.0f)
@@ -411,27 +734,112 @@ struct cpu_gemm
                 });
             }
 
-            migemm(result, args[0], args[1], op.alpha, op.beta);
+            gemm(result, args[0], args[1], op.beta);
 
             return result;
         }
 
         // 2 input arguments
-        migemm(result, args[0], args[1], op.alpha, 0.0f);
+        gemm(result, args[0], args[1], 0.0f);
+
+        return result;
+    }
+
+    bool is_packed() const { return not packed_b.lens().empty(); }
+
+    void gemm(const argument& c, const argument& a, const argument& b, float beta) const
+    {
+        if(is_packed())
+            migemm_packed(c, a, b, gemm_operand::b, op.alpha, beta, acc);
+        else
+            migemm(c, a, b, op.alpha, beta, acc);
+    }
 
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
+    {
+        return shapes.size() - 1;
+    }
+};
+
+struct cpu_quant_gemm
+{
+    op::quant_dot op;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return migraphx::reflect(self.op, f);
+    }
+    std::string name() const { return "cpu::quant_dot"; }
+    shape compute_shape(std::vector<shape> inputs) const
+    {
+        inputs.pop_back();
+        return op.compute_shape(inputs);
+    }
+
+    argument compute(context&, const shape&, std::vector<argument> args) const
+    {
+        argument result = args.back();
+        migemm(result, args[0], args[1], 1.0f, 0.0f);
         return result;
     }
+
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
+    {
+        return shapes.size() - 1;
+    }
 };
 
 struct cpu_gather
 {
     op::gather op;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return migraphx::reflect(self.op, f);
+    }
     std::string name() const { return "cpu::gather"; }
-    shape compute_shape(const std::vector<shape>& inputs) const { return op.compute_shape(inputs); }
+    shape compute_shape(std::vector<shape> inputs) const
+    {
+        inputs.pop_back();
+        return op.compute_shape(inputs);
+    }
 
     argument compute(context&, const shape& output_shape, std::vector<argument> args) const
     {
-        return op.compute(output_shape, std::move(args));
+        argument result = args.back();
+        // negative axis means counting dimensions from back
+        int axis_index =
+            (op.axis < 0) ? static_cast<int>(args[0].get_shape().lens().size() + op.axis) : op.axis;
+
+        visit_all(result, args[0])([&](auto output, auto data) {
+            args[1].visit([&](auto indices) {
+                if(output_shape.scalar())
+                {
+                    output[0] = data[indices.front()];
+                }
+                else
+                {
+                    auto out_lens        = data.get_shape().lens();
+                    out_lens[axis_index] = indices.get_shape().elements();
+                    migraphx::shape out_comp_shape{data.get_shape().type(), out_lens};
+                    shape_for_each(out_comp_shape, [&](const auto& out_idx) {
+                        auto data_idx        = out_idx;
+                        data_idx[axis_index] = indices[data_idx[axis_index]];
+                        output[out_comp_shape.index(out_idx.begin(), out_idx.end())] =
+                            data(data_idx.begin(), data_idx.end());
+                    });
+                }
+            });
+        });
+
+        return result;
+    }
+
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
+    {
+        return shapes.size() - 1;
     }
 };
 
@@ -460,6 +868,7 @@ struct exp_op
     {
         return [](auto x) { return std::exp(x); };
     }
+    void apply(const float* x, float* y, std::size_t n) const { vector_exp(x, y, n); }
 };
 
 struct log_op
@@ -469,6 +878,7 @@ struct log_op
     {
         return [](auto x) { return std::log(x); };
     }
+    void apply(const float* x, float* y, std::size_t n) const { vector_log(x, y, n); }
 };
 
 struct sin_op
@@ -478,6 +888,7 @@ struct sin_op
     {
         return [](auto x) { return std::sin(x); };
     }
+    void apply(const float* x, float* y, std::size_t n) const { vector_sin(x, y, n); }
 };
 
 struct cos_op
@@ -487,6 +898,7 @@ struct cos_op
     {
         return [](auto x) { return std::cos(x); };
     }
+    void apply(const float* x, float* y, std::size_t n) const { vector_cos(x, y, n); }
 };
 
 struct tan_op
@@ -550,6 +962,7 @@ struct tanh_op
     {
         return [](auto x) { return std::tanh(x); };
     }
+    void apply(const float* x, float* y, std::size_t n) const { vector_tanh(x, y, n); }
 };
 
 struct sigmoid_op
@@ -559,6 +972,17 @@ struct sigmoid_op
     {
         return [](auto x) { return 1.f / (1.f + std::exp(-x)); };
     }
+    void apply(const float* x, float* y, std::size_t n) const { vector_sigmoid(x, y, n); }
+};
+
+struct erf_op
+{
+    std::string name() const { return "cpu::erf"; }
+    auto fcn() const
+    {
+        return [](auto x) { return std::erf(x); };
+    }
+    void apply(const float* x, float* y, std::size_t n) const { vector_erf(x, y, n); }
 };
 
 struct neg_op
@@ -582,6 +1006,12 @@ struct relu_op
 struct leaky_relu_op
 {
     op::leaky_relu op;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return migraphx::reflect(self.op, f);
+    }
     std::string name() const { return "cpu::leaky_relu"; }
     auto fcn() const
     {
@@ -593,22 +1023,68 @@ struct leaky_relu_op
 struct elu_op
 {
     op::elu op;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return migraphx::reflect(self.op, f);
+    }
     std::string name() const { return "cpu::elu"; }
     auto fcn() const
     {
         auto& a = op.alpha;
         return [a](auto x) { return x > 0 ? x : a * std::expm1(x); };
     }
+    void apply(const float* x, float* y, std::size_t n) const { vector_elu(x, y, n, op.alpha); }
 };
 
+// The number of elements each task of a pointwise operator computes
+const std::size_t pointwise_grain = 16384;
+
+// Calls f(start, len) on chunks of n elements, in parallel when there is more
+// than one chunk
+template <class F>
+void pointwise_chunks(std::size_t n, F f)
+{
+    if(n <= pointwise_grain)
+    {
+        f(0, n);
+        return;
+    }
+    par_for((n + pointwise_grain - 1) / pointwise_grain, 1, [&](std::size_t i) {
+        const std::size_t start = i * pointwise_grain;
+        f(start, std::min(pointwise_grain, n - start));
+    });
+}
+
+template <class Op, class T, class U>
+void unary_kernel(rank<0>, const Op& op, const T* x, U* y, std::size_t n)
+{
+    std::transform(x, x + n, y, op.fcn());
+}
+
+// Ops with a vectorized float kernel
+template <class Op>
+auto unary_kernel(rank<1>, const Op& op, const float* x, float* y, std::size_t n)
+    -> decltype(op.apply(x, y, n))
+{
+    op.apply(x, y, n);
+}
+
 template <typename Op>
 struct cpu_unary
 {
     Op op;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return migraphx::reflect(self.op, f);
+    }
     std::string name() const { return op.name(); }
     shape compute_shape(const std::vector<shape>& inputs) const
     {
-        check_shapes{inputs}.has(1);
+        check_shapes{inputs}.has(2);
         auto s = inputs.at(0);
         if(s.packed())
         {
@@ -620,133 +1096,255 @@ struct cpu_unary
         }
     }
 
-    argument compute(context&, const shape& output_shape, std::vector<argument> args) const
+    argument compute(context&, const shape&, std::vector<argument> args) const
     {
-        argument result{output_shape};
-        result.visit([&](auto output) {
-            args[0].visit([&](auto input) {
-                if(input.get_shape().standard())
-                {
-                    std::transform(input.begin(), input.end(), output.begin(), op.fcn());
-                }
-                else
-                {
-                    shape_for_each(output.get_shape(), [&](const auto& idx) {
-                        output(idx.begin(), idx.end()) = op.fcn()(input(idx.begin(), idx.end()));
-                    });
-                }
-            });
+        argument result = args.back();
+        visit_all(result, args[0])([&](auto output, auto input) {
+            if(input.get_shape().standard())
+            {
+                auto* x = input.data();
+                auto* y = output.data();
+                pointwise_chunks(output.get_shape().elements(), [&](auto start, auto len) {
+                    unary_kernel(rank<1>{}, op, x + start, y + start, len);
+                });
+            }
+            else
+            {
+                auto f = op.fcn();
+                par_for_each_offset(output.get_shape(), input.get_shape())(
+                    [&](auto i, auto j) { output.data()[i] = f(input.data()[j]); });
+            }
         });
 
         return result;
     }
+
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
+    {
+        return shapes.size() - 1;
+    }
 };
 
-struct softmax2d
+// Converts between float values and their quantized values, which are
+// stored in a different type
+template <typename Op>
+struct cpu_quantize
 {
-    std::string name() const { return "cpu::softmax2d"; }
-    shape compute_shape(const std::vector<shape>& inputs) const { return inputs.front(); }
-    argument compute(context&, const shape& output_shape, std::vector<argument> args) const
+    Op op;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
     {
-        argument result{output_shape};
-        visit_all(result, args[0])([&](auto output, auto input) {
-            using value_type = typename decltype(input)::value_type;
-            auto nb          = input.get_shape().lens()[0];
-            auto nc          = input.get_shape().lens()[1];
-            auto nh          = input.get_shape().lens()[2];
-            auto nw          = input.get_shape().lens()[3];
-            dfor(nb, nh, nw)([&](std::size_t b, std::size_t i, std::size_t j) {
-                value_type cmax = std::numeric_limits<value_type>::lowest();
-                for(std::size_t c = 0; c < nc; c++)
-                {
-                    cmax = std::max(cmax, input(b, c, i, j));
-                }
-                for(std::size_t c = 0; c < nc; c++)
-                {
-                    output(b, c, i, j) = std::exp(input(b, c, i, j) - cmax);
-                }
-                value_type sum = value_type(0);
-                for(std::size_t c = 0; c < nc; c++)
-                {
-                    sum += output(b, c, i, j);
-                }
-                for(std::size_t c = 0; c < nc; c++)
-                {
-                    output(b, c, i, j) = output(b, c, i, j) / sum;
-                }
-            });
+        return migraphx::reflect(self.op, f);
+    }
+    std::string name() const { return "cpu::" + op.name(); }
+    shape compute_shape(std::vector<shape> inputs) const
+    {
+        inputs.pop_back();
+        return op.compute_shape(inputs);
+    }
+
+    argument compute(context&, const shape&, std::vector<argument> args) const
+    {
+        argument result = args.back();
+        auto f          = op.apply();
+        // The type of the output is the type returned by the conversion
+        auto output = result.get<decltype(f(0.0f))>();
+        args[0].visit([&](auto input) {
+            if(input.get_shape().standard())
+            {
+                par_for(input.get_shape().elements(), 4096, [&](std::size_t i) {
+                    output.data()[i] = f(input.data()[i]);
+                });
+            }
+            else
+            {
+                par_for_each_offset(output.get_shape(), input.get_shape())(
+                    [&](auto i, auto j) { output.data()[i] = f(input.data()[j]); });
+            }
         });
         return result;
     }
+
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
+    {
+        return shapes.size() - 1;
+    }
+};
+
+struct cpu_softmax
+{
+    op::softmax op;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return migraphx::reflect(self.op, f);
+    }
+    std::string name() const { return "cpu::softmax"; }
+    shape compute_shape(const std::vector<shape>& inputs) const
+    {
+        check_shapes{inputs, *this}.has(2).standard();
+        return op.compute_shape({inputs.at(0)});
+    }
+    argument compute(context&, const shape&, std::vector<argument> args) const
+    {
+        argument result = args.back();
+        softmax(result, args[0], op.axis);
+        return result;
+    }
+
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
+    {
+        return shapes.size() - 1;
+    }
 };
 
 struct cpu_logsoftmax
 {
     op::logsoftmax op;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return migraphx::reflect(self.op, f);
+    }
     std::string name() const { return "cpu::logsoftmax"; }
-    shape compute_shape(const std::vector<shape>& inputs) const { return op.compute_shape(inputs); }
+    shape compute_shape(std::vector<shape> inputs) const
+    {
+        inputs.pop_back();
+        return op.compute_shape(inputs);
+    }
 
-    template <typename T>
-    std::size_t compute_batch_index(const T& idx, shape& batch_shape, int axis) const
+    argument compute(context&, const shape&, std::vector<argument> args) const
     {
-        if(axis == 0)
-        {
-            return 0;
-        }
-        else
-        {
-            std::vector<std::size_t> batch_idx(idx.begin(), idx.begin() + axis);
-            return batch_shape.index(batch_idx.begin(), batch_idx.end());
-        }
+        argument result = args.back();
+        logsoftmax(result, args[0], op.axis);
+        return result;
     }
 
-    argument compute(context&, const shape& output_shape, std::vector<argument> args) const
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
     {
-        argument result{output_shape};
-        auto lens = output_shape.lens();
-        std::vector<std::size_t> batch_lens{};
-        if(op.axis == 0)
-        {
-            batch_lens.push_back(1);
-        }
-        else
-        {
-            batch_lens.insert(batch_lens.begin(), lens.begin(), lens.begin() + op.axis);
-        }
-        shape batch_shape{migraphx::shape::uint32_type, batch_lens};
-        visit_all(result, args[0])([&](auto output, auto input) {
-            using value_type = typename decltype(input)::value_type;
-            std::vector<value_type> batch_max(batch_shape.elements(),
-                                              std::numeric_limits<value_type>::lowest());
-            shape_for_each(output_shape, [&](auto idx) {
-                auto index       = this->compute_batch_index(idx, batch_shape, op.axis);
-                batch_max[index] = std::max(batch_max[index], input(idx.begin(), idx.end()));
-            });
+        return shapes.size() - 1;
+    }
+};
 
-            shape_for_each(output_shape, [&](auto idx) {
-                auto index = this->compute_batch_index(idx, batch_shape, op.axis);
-                output(idx.begin(), idx.end()) = input(idx.begin(), idx.end()) - batch_max[index];
-            });
+static void compute_rnn(const op::rnn& op,
+                        accumulate acc,
+                        const argument& result,
+                        const std::vector<argument>& args)
+{
+    rnn(result, args, op, acc);
+}
 
-            std::vector<value_type> batch_sum(batch_shape.elements(), value_type(0));
-            shape_for_each(output_shape, [&](auto idx) {
-                auto index = this->compute_batch_index(idx, batch_shape, op.axis);
-                batch_sum[index] += std::exp(output(idx.begin(), idx.end()));
-            });
+static void compute_rnn(const op::gru& op,
+                        accumulate acc,
+                        const argument& result,
+                        const std::vector<argument>& args)
+{
+    gru(result, args, op, acc);
+}
+
+static void
+compute_rnn(const op::lstm& op, accumulate acc, const argument& result, std::vector<argument> args)
+{
+    argument cell = args.back();
+    args.pop_back();
+    lstm(result, cell, args, op, acc);
+}
+
+// The inputs are the sequence, w, r, bias and initial hidden state, followed
+// by the initial cell state, peephole weights and cell state buffer of an
+// lstm, and the output
+template <class Op>
+struct cpu_rnn
+{
+    Op op;
+    accumulate acc = accumulate::mixed;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return pack_join(migraphx::reflect(self.op, f), pack(f(self.acc, "accumulate")));
+    }
+    std::string name() const { return "cpu::" + op.name(); }
+    shape compute_shape(const std::vector<shape>& inputs) const
+    {
+        check_shapes{inputs, *this}.standard();
+        return op.compute_shape({inputs.at(0), inputs.at(1), inputs.at(2)});
+    }
+
+    argument compute(context&, const shape&, std::vector<argument> args) const
+    {
+        argument result = args.back();
+        args.pop_back();
+        compute_rnn(op, acc, result, args);
+        return result;
+    }
 
-            for(std::size_t i = 0; i < batch_sum.size(); ++i)
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
+    {
+        return shapes.size() - 1;
+    }
+};
+
+// The hidden state of the last step of each direction, which is the first
+// step of the reverse direction
+struct cpu_rnn_last_output
+{
+    op::rnn_direction direction = op::rnn_direction::forward;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return pack(f(self.direction, "direction"));
+    }
+    std::string name() const { return "cpu::rnn_last_output"; }
+    shape compute_shape(std::vector<shape> inputs) const
+    {
+        inputs.pop_back();
+        return op::rnn_last_output{}.compute_shape(inputs);
+    }
+
+    argument compute(context&, const shape&, std::vector<argument> args) const
+    {
+        argument result        = args.back();
+        const auto& lens       = args[0].get_shape().lens();
+        const std::size_t dirs = lens[1];
+        const std::size_t n    = result.get_shape().elements() / dirs;
+        visit_all(result, args[0])([&](auto output, auto input) {
+            for(std::size_t d = 0; d < dirs; d++)
             {
-                batch_sum[i] = std::log(batch_sum[i]);
+                bool reverse = direction == op::rnn_direction::reverse or d == 1;
+                auto step    = reverse ? 0 : lens[0] - 1;
+                auto first   = input.begin() + (step * dirs + d) * n;
+                std::copy(first, first + n, output.begin() + d * n);
             }
-
-            shape_for_each(output_shape, [&](auto idx) {
-                auto index = this->compute_batch_index(idx, batch_shape, op.axis);
-                output(idx.begin(), idx.end()) -= batch_sum[index];
-            });
         });
-
         return result;
     }
+
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
+    {
+        return shapes.size() - 1;
+    }
+};
+
+// The cell state of the last step, which the lstm has written to its cell
+// state buffer
+struct cpu_lstm_last_cell_output
+{
+    std::string name() const { return "cpu::lstm_last_cell_output"; }
+    shape compute_shape(const std::vector<shape>& inputs) const
+    {
+        check_shapes{inputs, *this}.has(2);
+        return inputs.at(1);
+    }
+    argument compute(context&, const shape&, std::vector<argument> args) const
+    {
+        return args.at(1);
+    }
+    std::ptrdiff_t output_alias(const std::vector<shape>&) const { return 1; }
 };
 
 struct add_op
@@ -807,10 +1405,16 @@ template <typename Op>
 struct cpu_binary
 {
     Op op;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return migraphx::reflect(self.op, f);
+    }
     std::string name() const { return "cpu::" + op.name(); }
     shape compute_shape(const std::vector<shape>& inputs) const
     {
-        check_shapes{inputs}.has(2).same_type().same_dims();
+        check_shapes{inputs}.has(3).same_type().same_dims();
         auto s0 = inputs.at(0);
         auto s1 = inputs.at(1);
         if(s0 == s1 and s0.packed())
@@ -823,34 +1427,46 @@ struct cpu_binary
         }
     }
 
-    argument compute(context&, const shape& output_shape, std::vector<argument> args) const
+    argument compute(context&, const shape&, std::vector<argument> args) const
     {
-        argument result{output_shape};
+        argument result = args.back();
         visit_all(result, args[0], args[1])([&](auto output, auto input1, auto input2) {
             auto s1 = input1.get_shape();
             auto s2 = input2.get_shape();
             if(s1 == s2 and s1.standard())
             {
-                std::transform(
-                    input1.begin(), input1.end(), input2.begin(), output.begin(), op.fcn());
+                auto* x = input1.data();
+                auto* y = input2.data();
+                auto* z = output.data();
+                auto f  = op.fcn();
+                pointwise_chunks(output.get_shape().elements(), [&](auto start, auto len) {
+                    std::transform(x + start, x + start + len, y + start, z + start, f);
+                });
             }
             else
             {
-                shape_for_each(output.get_shape(), [&](const auto& idx) {
-                    output(idx.begin(), idx.end()) =
-                        op.fcn()(input1(idx.begin(), idx.end()), input2(idx.begin(), idx.end()));
+                auto f = op.fcn();
+                par_for_each_offset(output.get_shape(), s1, s2)([&](auto i, auto j, auto k) {
+                    output.data()[i] = f(input1.data()[j], input2.data()[k]);
                 });
             }
         });
 
         return result;
     }
+
+    std::ptrdiff_t output_alias(const std::vector<shape>& shapes) const
+    {
+        return shapes.size() - 1;
+    }
 };
 
 struct cpu_apply
 {
     program* prog;
+    accumulate acc = accumulate::mixed;
     std::unordered_map<std::string, std::function<void(instruction_ref)>> apply_map{};
+    instruction_ref last{};
 
     template <class T>
     auto simple_op()
@@ -864,11 +1480,21 @@ struct cpu_apply
         return [this](instruction_ref ins) { apply_extend_op<T, Op>(ins); };
     }
 
+    // The operator accumulates with the policy selected on the target
+    template <class T, class Op>
+    auto accumulate_op()
+    {
+        return [this](instruction_ref ins) {
+            auto&& op = any_cast<Op>(ins->get_operator());
+            replace_with_output(ins, T{op, acc});
+        };
+    }
+
     void init()
     {
         apply_map["im2col"]      = extend_op<cpu_im2col, op::im2col>();
-        apply_map["convolution"] = extend_op<cpu_convolution, op::convolution>();
-        apply_map["dot"]         = extend_op<cpu_gemm, op::dot>();
+        apply_map["convolution"] = [this](instruction_ref ins) { apply_convolution(ins); };
+        apply_map["dot"]         = [this](instruction_ref ins) { apply_dot(ins); };
         apply_map["batch_norm_inference"] =
             extend_op<cpu_batch_norm_inference, op::batch_norm_inference>();
         apply_map["lrn"]        = extend_op<cpu_lrn, op::lrn>();
@@ -886,6 +1512,7 @@ struct cpu_apply
         apply_map["cosh"]       = simple_op<cpu_unary<cosh_op>>();
         apply_map["tanh"]       = simple_op<cpu_unary<tanh_op>>();
         apply_map["sigmoid"]    = simple_op<cpu_unary<sigmoid_op>>();
+        apply_map["erf"]        = simple_op<cpu_unary<erf_op>>();
         apply_map["exp"]        = simple_op<cpu_unary<exp_op>>();
         apply_map["log"]        = simple_op<cpu_unary<log_op>>();
         apply_map["neg"]        = simple_op<cpu_unary<neg_op>>();
@@ -903,12 +1530,45 @@ struct cpu_apply
         apply_map["max"]        = simple_op<cpu_binary<max_op>>();
         apply_map["min"]        = simple_op<cpu_binary<min_op>>();
 
-        apply_map["softmax"] = simple_op<softmax2d>();
+        apply_map["softmax"] = extend_op<cpu_softmax, op::softmax>();
+
+        apply_map["rnn"]  = [this](instruction_ref ins) { apply_rnn<op::rnn>(ins, 1); };
+        apply_map["gru"]  = [this](instruction_ref ins) { apply_rnn<op::gru>(ins, 3); };
+        apply_map["lstm"] = [this](instruction_ref ins) { apply_lstm(ins); };
+
+        apply_map["quant_convolution"] = [this](instruction_ref ins) {
+            apply_quant_convolution(ins);
+        };
+        apply_map["quant_dot"] = extend_op<cpu_quant_gemm, op::quant_dot>();
+        apply_map["quantizelinear"] =
+            extend_op<cpu_quantize<op::quantizelinear>, op::quantizelinear>();
+        apply_map["dequantizelinear"] =
+            extend_op<cpu_quantize<op::dequantizelinear>, op::dequantizelinear>();
+    }
+
+    bool is_lowered(instruction_ref ins) const
+    {
+        return ins->name() == "pooling" or apply_map.count(ins->name()) > 0;
+    }
+
+    // Find the instruction that will write the program output, following the
+    // aliases of the operators that are not lowered
+    instruction_ref get_output(instruction_ref ins) const
+    {
+        while(not is_lowered(ins))
+        {
+            auto alias = instruction::get_output_alias(ins, true);
+            if(alias == ins)
+                break;
+            ins = alias;
+        }
+        return ins;
     }
 
     void apply()
     {
         init();
+        this->last = get_output(std::prev(prog->end()));
         for(auto it : iterator_for(*prog))
         {
             if(it->name() == "pooling")
@@ -922,30 +1582,264 @@ struct cpu_apply
         }
     }
 
+    instruction_ref insert_allocation(instruction_ref ins, const shape& s)
+    {
+        // The output is not planned with the other allocations so the result is not
+        // overwritten by the next eval
+        if(ins == last and prog->get_parameter("output") == prog->end())
+        {
+            return prog->add_parameter("output", s);
+        }
+        else
+        {
+            return prog->insert_instruction(ins, allocate{s});
+        }
+    }
+
+    void replace_with_output(instruction_ref ins, const operation& op)
+    {
+        auto inputs = ins->inputs();
+        inputs.push_back(insert_allocation(ins, ins->get_shape()));
+        prog->replace_instruction(ins, op, inputs);
+    }
+
     template <class T>
     void apply_simple_op(instruction_ref ins)
     {
-        prog->replace_instruction(ins, T{}, ins->inputs());
+        replace_with_output(ins, T{});
     }
 
     template <class T, class Op>
     void apply_extend_op(instruction_ref ins)
     {
         auto&& op = any_cast<Op>(ins->get_operator());
-        prog->replace_instruction(ins, T{op}, ins->inputs());
+        replace_with_output(ins, T{op});
+    }
+
+    template <class Op>
+    void apply_gemm_convolution(instruction_ref ins, std::vector<instruction_ref> inputs)
+    {
+        using conv  = cpu_gemm_convolution<Op>;
+        auto&& op   = any_cast<Op>(ins->get_operator());
+        auto shapes = to_shapes(inputs);
+        auto ws      = conv::workspace_shape(op, shapes, ins->get_shape());
+        auto weights = skip_contiguous(inputs[1]);
+        shape packed{};
+        // The panels of int8 weights would be int32, so they are left as they are
+        if(not conv::quantized() and weights->name() == "@literal")
+        {
+            auto w    = conv::pack_weights(op, weights->get_literal().get_argument(), acc);
+            packed    = inputs[1]->get_shape();
+            inputs[1] = prog->add_literal(literal{w});
+        }
+        inputs.push_back(prog->insert_instruction(ins, allocate{ws}));
+        inputs.push_back(insert_allocation(ins, ins->get_shape()));
+        prog->replace_instruction(ins, conv{op, acc, packed}, inputs);
+    }
+
+    // Literal operands are copied by auto_contiguous, but they can be packed
+    // from any layout
+    static instruction_ref skip_contiguous(instruction_ref ins)
+    {
+        if(ins->name() == "contiguous" or ins->name() == "cpu::contiguous")
+            return ins->inputs().front();
+        return ins;
+    }
+
+    static bool is_packable(const shape& s)
+    {
+        return s.type() == shape::float_type or s.type() == shape::half_type or
+               s.type() == shape::double_type;
+    }
+
+    // A constant B is packed once here instead of on every call
+    void apply_dot(instruction_ref ins)
+    {
+        auto&& op   = any_cast<op::dot>(ins->get_operator());
+        auto inputs = ins->inputs();
+        shape packed{};
+        const auto& as = inputs[0]->get_shape();
+        const auto& bs = inputs[1]->get_shape();
+        auto w         = skip_contiguous(inputs[1]);
+        if(w->name() == "@literal" and is_packable(bs) and as.lens().size() == 2 and
+           bs.lens().size() == 2)
+        {
+            auto b    = w->get_literal().get_argument();
+            packed    = bs;
+            b         = pack_gemm_operand(b, gemm_operand::b, acc);
+            inputs[1] = prog->add_literal(literal{b});
+        }
+        inputs.push_back(insert_allocation(ins, ins->get_shape()));
+        prog->replace_instruction(ins, cpu_gemm{op, acc, packed}, inputs);
+    }
+
+    void apply_convolution(instruction_ref ins)
+    {
+        auto&& op = any_cast<op::convolution>(ins->get_operator());
+        if(cpu_gemm_convolution<op::convolution>::is_supported(to_shapes(ins->inputs())))
+            apply_gemm_convolution<op::convolution>(ins, ins->inputs());
+        else
+            replace_with_output(ins, cpu_convolution{op, acc});
+    }
+
+    // There is only the gemm kernel for the quantized convolution, so the
+    // inputs are copied when they are not standard
+    void apply_quant_convolution(instruction_ref ins)
+    {
+        auto inputs = ins->inputs();
+        std::transform(inputs.begin(), inputs.end(), inputs.begin(), [&](instruction_ref input) {
+            const auto& s = input->get_shape();
+            if(s.standard())
+                return input;
+            auto output = prog->insert_instruction(ins, allocate{{s.type(), s.lens()}});
+            return prog->insert_instruction(ins, cpu_contiguous{}, input, output);
+        });
+        if(not cpu_gemm_convolution<op::quant_convolution>::is_supported(to_shapes(inputs)))
+            MIGRAPHX_THROW("QUANT_CONVOLUTION: only 2d convolutions of int8 values are supported");
+        apply_gemm_convolution<op::quant_convolution>(ins, inputs);
+    }
+
+    // The inputs of a recurrent kernel, where the missing optional inputs are
+    // zeros. The sequence lengths are not used.
+    std::vector<instruction_ref> rnn_inputs(instruction_ref ins, std::size_t gates)
+    {
+        auto args              = ins->inputs();
+        const auto& xs         = args[0]->get_shape();
+        const auto& rl         = args[2]->get_shape().lens();
+        const std::size_t dirs = rl[0];
+        const std::size_t hs   = rl[2];
+        const std::size_t bs   = xs.lens()[1];
+        auto input             = [&](std::size_t i, std::vector<std::size_t> lens) {
+            if(i < args.size() and args[i]->name() != "undefined")
+                return args[i];
+            shape s{xs.type(), std::move(lens)};
+            return prog->add_literal(literal{s, std::vector<float>(s.elements())});
+        };
+        std::vector<instruction_ref> inputs = {
+            args[0], args[1], args[2], input(3, {dirs, 2 * gates * hs}), input(5, {dirs, bs, hs})};
+        if(gates == 4)
+        {
+            inputs.push_back(input(6, {dirs, bs, hs}));
+            inputs.push_back(input(7, {dirs, 3 * hs}));
+        }
+        return inputs;
+    }
+
+    // The last hidden state is copied from the output of the kernel
+    void apply_rnn_last_output(const std::vector<instruction_ref>& outputs,
+                               op::rnn_direction direction)
+    {
+        for(auto output : outputs)
+        {
+            if(output->name() == "rnn_last_output")
+                replace_with_output(output, cpu_rnn_last_output{direction});
+        }
+    }
+
+    template <class Op>
+    void apply_rnn(instruction_ref ins, std::size_t gates)
+    {
+        auto op     = any_cast<Op>(ins->get_operator());
+        auto inputs = rnn_inputs(ins, gates);
+        auto users  = ins->outputs();
+        // The activation functions are listed for each direction
+        if(gates == 1)
+            op.actv_funcs = rewrite_rnn{}.vanilla_rnn_actv_funcs(ins);
+        else
+            op.actv_funcs = rewrite_rnn{}.gru_actv_funcs(ins);
+        inputs.push_back(insert_allocation(ins, ins->get_shape()));
+        prog->replace_instruction(ins, cpu_rnn<Op>{op, acc}, inputs);
+        apply_rnn_last_output(users, op.direction);
+    }
+
+    // The cell state is kept in a buffer, which is the output of the program
+    // when it returns the last cell state
+    void apply_lstm(instruction_ref ins)
+    {
+        auto op       = any_cast<op::lstm>(ins->get_operator());
+        auto inputs   = rnn_inputs(ins, 4);
+        auto users    = ins->outputs();
+        op.actv_funcs = rewrite_rnn{}.lstm_actv_funcs(ins);
+        shape cs      = inputs[5]->get_shape();
+        auto cell     = std::find_if(users.begin(), users.end(), [&](auto user) {
+            return user->name() == "lstm_last_cell_output" and user == last;
+        });
+        inputs.push_back(cell == users.end() ? prog->insert_instruction(ins, allocate{cs})
+                                             : insert_allocation(*cell, cs));
+        inputs.push_back(insert_allocation(ins, ins->get_shape()));
+        prog->replace_instruction(ins, cpu_rnn<op::lstm>{op, acc}, inputs);
+        for(auto user : users)
+        {
+            if(user->name() == "lstm_last_cell_output")
+                prog->replace_instruction(
+                    user, cpu_lstm_last_cell_output{}, ins, inputs[inputs.size() - 2]);
+        }
+        apply_rnn_last_output(users, op.direction);
     }
 
     void apply_pooling(instruction_ref ins)
     {
         auto&& op = any_cast<op::pooling>(ins->get_operator());
         if(op.mode == "max")
-            prog->replace_instruction(ins, cpu_pooling<max_pool>{op}, ins->inputs());
+            replace_with_output(ins, cpu_pooling<max_pool>{op, acc});
         else if(op.mode == "average")
-            prog->replace_instruction(ins, cpu_pooling<avg_pool>{op}, ins->inputs());
+            replace_with_output(ins, cpu_pooling<avg_pool>{op, acc});
     }
 };
 
-void lowering::apply(program& p) const { cpu_apply{&p}.apply(); }
+void lowering::apply(program& p) const { cpu_apply{&p, acc}.apply(); }
+
+// Make the lowered operators loadable from a saved program
+static const bool cpu_ops_registered = register_ops<cpu_batch_norm_inference,
+                                                    cpu_lrn,
+                                                    cpu_convolution,
+                                                    cpu_gemm_convolution<op::convolution>,
+                                                    cpu_gemm_convolution<op::quant_convolution>,
+                                                    cpu_im2col,
+                                                    cpu_pooling<max_pool>,
+                                                    cpu_pooling<avg_pool>,
+                                                    cpu_contiguous,
+                                                    cpu_pad,
+                                                    cpu_concat,
+                                                    cpu_gemm,
+                                                    cpu_quant_gemm,
+                                                    cpu_quantize<op::quantizelinear>,
+                                                    cpu_quantize<op::dequantizelinear>,
+                                                    cpu_gather,
+                                                    cpu_unary<clip_op>,
+                                                    cpu_unary<leaky_relu_op>,
+                                                    cpu_unary<elu_op>,
+                                                    cpu_unary<identity_op>,
+                                                    cpu_unary<abs_op>,
+                                                    cpu_unary<exp_op>,
+                                                    cpu_unary<log_op>,
+                                                    cpu_unary<sin_op>,
+                                                    cpu_unary<cos_op>,
+                                                    cpu_unary<tan_op>,
+                                                    cpu_unary<asin_op>,
+                                                    cpu_unary<acos_op>,
+                                                    cpu_unary<atan_op>,
+                                                    cpu_unary<sinh_op>,
+                                                    cpu_unary<cosh_op>,
+                                                    cpu_unary<tanh_op>,
+                                                    cpu_unary<sigmoid_op>,
+                                                    cpu_unary<erf_op>,
+                                                    cpu_unary<neg_op>,
+                                                    cpu_unary<relu_op>,
+                                                    cpu_softmax,
+                                                    cpu_logsoftmax,
+                                                    cpu_rnn<op::rnn>,
+                                                    cpu_rnn<op::gru>,
+                                                    cpu_rnn<op::lstm>,
+                                                    cpu_rnn_last_output,
+                                                    cpu_lstm_last_cell_output,
+                                                    cpu_binary<add_op>,
+                                                    cpu_binary<sub_op>,
+                                                    cpu_binary<mul_op>,
+                                                    cpu_binary<div_op>,
+                                                    cpu_binary<max_op>,
+                                                    cpu_binary<min_op>,
+                                                    allocate>();
 
 } // namespace cpu
 } // namespace MIGRAPHX_INLINE_NS
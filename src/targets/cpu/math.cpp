@@ -0,0 +1,83 @@
+#include <migraphx/cpu/math.hpp>
+#include <cmath>
+#include <limits>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+MIGRAPHX_CPU_TARGETS
+void vector_exp(const float* x, float* y, std::size_t n)
+{
+    for(std::size_t i = 0; i < n; i++)
+        y[i] = fast_exp(x[i]);
+}
+
+MIGRAPHX_CPU_TARGETS
+void vector_log(const float* x, float* y, std::size_t n)
+{
+    for(std::size_t i = 0; i < n; i++)
+        y[i] = fast_log(x[i]);
+    for(std::size_t i = 0; i < n; i++)
+    {
+        if(not(x[i] >= std::numeric_limits<float>::min() and
+               x[i] <= std::numeric_limits<float>::max()))
+            y[i] = std::log(x[i]);
+    }
+}
+
+MIGRAPHX_CPU_TARGETS
+void vector_tanh(const float* x, float* y, std::size_t n)
+{
+    for(std::size_t i = 0; i < n; i++)
+        y[i] = fast_tanh(x[i]);
+}
+
+MIGRAPHX_CPU_TARGETS
+void vector_sigmoid(const float* x, float* y, std::size_t n)
+{
+    for(std::size_t i = 0; i < n; i++)
+        y[i] = fast_sigmoid(x[i]);
+}
+
+MIGRAPHX_CPU_TARGETS
+void vector_erf(const float* x, float* y, std::size_t n)
+{
+    for(std::size_t i = 0; i < n; i++)
+        y[i] = fast_erf(x[i]);
+}
+
+MIGRAPHX_CPU_TARGETS
+void vector_sin(const float* x, float* y, std::size_t n)
+{
+    for(std::size_t i = 0; i < n; i++)
+        y[i] = fast_sin(x[i]);
+    for(std::size_t i = 0; i < n; i++)
+    {
+        if(not(std::abs(x[i]) < sincos_limit))
+            y[i] = std::sin(x[i]);
+    }
+}
+
+MIGRAPHX_CPU_TARGETS
+void vector_cos(const float* x, float* y, std::size_t n)
+{
+    for(std::size_t i = 0; i < n; i++)
+        y[i] = fast_cos(x[i]);
+    for(std::size_t i = 0; i < n; i++)
+    {
+        if(not(std::abs(x[i]) < sincos_limit))
+            y[i] = std::cos(x[i]);
+    }
+}
+
+MIGRAPHX_CPU_TARGETS
+void vector_elu(const float* x, float* y, std::size_t n, float alpha)
+{
+    for(std::size_t i = 0; i < n; i++)
+        y[i] = x[i] > 0.0f ? x[i] : alpha * fast_expm1(x[i]);
+}
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
@@ -0,0 +1,236 @@
+#include <migraphx/cpu/pooling.hpp>
+#include <migraphx/cpu/vectorize.hpp>
+#include <migraphx/cpu/convert.hpp>
+#include <migraphx/par_for.hpp>
+#include <array>
+#include <utility>
+#include <vector>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+// One channel plane and the window sliding over it
+struct pool_window
+{
+    std::size_t in_h;
+    std::size_t in_w;
+    std::size_t out_h;
+    std::size_t out_w;
+    op::pooling op;
+
+    // The input rows (axis 0) or columns (axis 1) read by output `i`,
+    // clipped to the input
+    std::pair<std::size_t, std::size_t> range(std::size_t axis, std::size_t i) const
+    {
+        const std::ptrdiff_t n = axis == 0 ? in_h : in_w;
+        std::ptrdiff_t start =
+            std::ptrdiff_t(i * op.stride[axis]) - std::ptrdiff_t(op.padding[axis]);
+        std::ptrdiff_t end = std::min<std::ptrdiff_t>(start + op.lengths[axis], n);
+        start              = std::max<std::ptrdiff_t>(start, 0);
+        return {start, std::max(start, end)};
+    }
+
+    bool is_global() const
+    {
+        return out_h == 1 and out_w == 1 and op.lengths[0] == in_h and
+               op.lengths[1] == in_w and op.padding[0] == 0 and op.padding[1] == 0;
+    }
+
+    bool is_square(std::size_t k, std::size_t s) const
+    {
+        return op.lengths[0] == k and op.lengths[1] == k and op.stride[0] == s and
+               op.stride[1] == s;
+    }
+};
+
+static std::size_t pool_count(std::pair<std::size_t, std::size_t> rows,
+                              std::pair<std::size_t, std::size_t> cols)
+{
+    return std::max<std::size_t>((rows.second - rows.first) * (cols.second - cols.first), 1);
+}
+
+template <class Op, class U, class T>
+MIGRAPHX_CPU_INLINE void global_pool(const T* x, T* y, std::size_t n)
+{
+    // Independent partial results, so the loop can be vectorized
+    constexpr std::size_t lanes = 8;
+    std::array<U, lanes> acc;
+    acc.fill(Op::template start<U>());
+    std::size_t i = 0;
+    for(; i + lanes <= n; i += lanes)
+    {
+        for(std::size_t l = 0; l < lanes; l++)
+            acc[l] = Op::apply(acc[l], U(x[i + l]));
+    }
+    for(; i < n; i++)
+        acc[0] = Op::apply(acc[0], U(x[i]));
+    U r = acc[0];
+    for(std::size_t l = 1; l < lanes; l++)
+        r = Op::apply(r, acc[l]);
+    *y = T(Op::final(r, std::max<std::size_t>(n, 1)));
+}
+
+template <std::size_t K, class Op, class U, class T>
+MIGRAPHX_CPU_INLINE void unrolled_pool(const T* x, T* y, const pool_window& w)
+{
+    for(std::size_t i = 0; i < w.out_h; i++)
+    {
+        auto rows = w.range(0, i);
+        for(std::size_t j = 0; j < w.out_w; j++)
+        {
+            auto cols = w.range(1, j);
+            U acc     = Op::template start<U>();
+            if(rows.second - rows.first == K and cols.second - cols.first == K)
+            {
+                const T* p = x + rows.first * w.in_w + cols.first;
+                for(std::size_t a = 0; a < K; a++)
+                {
+                    for(std::size_t b = 0; b < K; b++)
+                        acc = Op::apply(acc, U(p[a * w.in_w + b]));
+                }
+            }
+            else
+            {
+                // The window is clipped by the padding
+                for(std::size_t a = rows.first; a < rows.second; a++)
+                {
+                    for(std::size_t b = cols.first; b < cols.second; b++)
+                        acc = Op::apply(acc, U(x[a * w.in_w + b]));
+                }
+            }
+            y[i * w.out_w + j] = T(Op::final(acc, pool_count(rows, cols)));
+        }
+    }
+}
+
+// Reduce each input row over the columns of the window, and then reduce
+// those partial results over the rows of the window. The scratch holds
+// in_h + 1 rows of out_w values.
+template <class Op, class U, class T>
+MIGRAPHX_CPU_INLINE void separable_pool(const T* x, T* y, const pool_window& w, U* scratch)
+{
+    U* acc = scratch + w.in_h * w.out_w;
+    for(std::size_t h = 0; h < w.in_h; h++)
+    {
+        const T* row = x + h * w.in_w;
+        for(std::size_t j = 0; j < w.out_w; j++)
+        {
+            auto cols = w.range(1, j);
+            U r       = Op::template start<U>();
+            for(std::size_t b = cols.first; b < cols.second; b++)
+                r = Op::apply(r, U(row[b]));
+            scratch[h * w.out_w + j] = r;
+        }
+    }
+    for(std::size_t i = 0; i < w.out_h; i++)
+    {
+        auto rows = w.range(0, i);
+        std::fill(acc, acc + w.out_w, Op::template start<U>());
+        for(std::size_t a = rows.first; a < rows.second; a++)
+        {
+            const U* r = scratch + a * w.out_w;
+            for(std::size_t j = 0; j < w.out_w; j++)
+                acc[j] = Op::apply(acc[j], r[j]);
+        }
+        for(std::size_t j = 0; j < w.out_w; j++)
+            y[i * w.out_w + j] = T(Op::final(acc[j], pool_count(rows, w.range(1, j))));
+    }
+}
+
+// The values are accumulated in the type of the scratch
+template <class Op, class U, class T>
+MIGRAPHX_CPU_INLINE void pool_plane_impl(const T* x, T* y, const pool_window& w, U* scratch)
+{
+    if(w.is_global())
+        global_pool<Op, U>(x, y, w.in_h * w.in_w);
+    else if(w.is_square(2, 2))
+        unrolled_pool<2, Op, U>(x, y, w);
+    else if(w.is_square(3, 2))
+        unrolled_pool<3, Op, U>(x, y, w);
+    else
+        separable_pool<Op>(x, y, w, scratch);
+}
+
+template <class Op, class U, class T>
+static void pool_plane(const T* x, T* y, const pool_window& w, U* scratch, Op)
+{
+    pool_plane_impl<Op>(x, y, w, scratch);
+}
+
+MIGRAPHX_CPU_TARGETS
+static void pool_plane(const float* x, float* y, const pool_window& w, float* scratch, max_pool)
+{
+    pool_plane_impl<max_pool>(x, y, w, scratch);
+}
+
+MIGRAPHX_CPU_TARGETS
+static void pool_plane(const float* x, float* y, const pool_window& w, float* scratch, avg_pool)
+{
+    pool_plane_impl<avg_pool>(x, y, w, scratch);
+}
+
+template <class U>
+static U* pooling_scratch(std::size_t n)
+{
+    static thread_local std::vector<U> buffer;
+    if(buffer.size() < n)
+        buffer.resize(n);
+    return buffer.data();
+}
+
+// A half plane that accumulates in float is converted to float and pooled
+// by the float kernel
+template <class Op>
+static void pool_plane(const half* x, half* y, const pool_window& w, float* scratch, Op)
+{
+    static thread_local std::vector<float> buffer;
+    const std::size_t in_plane  = w.in_h * w.in_w;
+    const std::size_t out_plane = w.out_h * w.out_w;
+    buffer.resize(in_plane + out_plane);
+    convert(x, buffer.data(), in_plane);
+    pool_plane(buffer.data(), buffer.data() + in_plane, w, scratch, Op{});
+    convert(buffer.data() + in_plane, y, out_plane);
+}
+
+template <class Op>
+bool specialized_pooling(const argument& result,
+                         const argument& input,
+                         const op::pooling& op,
+                         accumulate acc)
+{
+    if(not input.get_shape().standard() or not result.get_shape().standard())
+        return false;
+    const auto& in_lens  = input.get_shape().lens();
+    const auto& out_lens = result.get_shape().lens();
+    pool_window w{in_lens[2], in_lens[3], out_lens[2], out_lens[3], op};
+    const std::size_t in_plane  = w.in_h * w.in_w;
+    const std::size_t out_plane = w.out_h * w.out_w;
+    visit_all(result, input)([&](auto output, auto x) {
+        using type = typename decltype(output)::value_type;
+        visit_accumulator<type>(acc, [&](auto zero) {
+            using acc_type = decltype(zero);
+            par_for(out_lens[0] * out_lens[1], 1, [&](std::size_t i) {
+                pool_plane(x.data() + i * in_plane,
+                           output.data() + i * out_plane,
+                           w,
+                           pooling_scratch<acc_type>((w.in_h + 1) * w.out_w),
+                           Op{});
+            });
+        });
+    });
+    return true;
+}
+
+template bool specialized_pooling<max_pool>(const argument& result,
+                                            const argument& input,
+                                            const op::pooling& op,
+                                            accumulate acc);
+template bool specialized_pooling<avg_pool>(const argument& result,
+                                            const argument& input,
+                                            const op::pooling& op,
+                                            accumulate acc);
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
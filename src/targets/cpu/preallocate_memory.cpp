@@ -0,0 +1,82 @@
+#include <migraphx/cpu/preallocate_memory.hpp>
+#include <migraphx/cpu/allocate.hpp>
+#include <migraphx/make_shared_array.hpp>
+#include <migraphx/iterator_for.hpp>
+#include <migraphx/instruction.hpp>
+#include <migraphx/serialize.hpp>
+#include <algorithm>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+static argument allocate_shared(const shape& s)
+{
+    // Share the buffer so copies of the argument do not copy the memory
+    auto buffer = make_shared_array<char>(s.bytes());
+    return {s, [=] { return buffer.get(); }};
+}
+
+struct load_memory
+{
+    shape s;
+    std::size_t n = 0;
+
+    template <class Self, class F>
+    static auto reflect(Self& self, F f)
+    {
+        return pack(f(self.s, "shape"), f(self.n, "n"));
+    }
+
+    std::string name() const { return "cpu::load_memory"; }
+    shape compute_shape(const std::vector<shape>& inputs) const
+    {
+        check_shapes{inputs}.has(0);
+        return s;
+    }
+    argument compute(context& ctx, const shape&, const std::vector<argument>&) const
+    {
+        return ctx.buffers.at(n);
+    }
+    // Allocate the buffer when the program was loaded instead of compiled
+    void finalize(context& ctx, const shape&, const std::vector<shape>&)
+    {
+        if(ctx.buffers.size() <= n)
+            ctx.buffers.resize(n + 1);
+        if(ctx.buffers[n].empty())
+            ctx.buffers[n] = allocate_shared(s);
+    }
+};
+
+static const bool load_memory_registered = register_ops<load_memory>();
+
+void preallocate_memory::apply(program& p) const
+{
+    assert(ctx != nullptr);
+    auto last = instruction::get_output_alias(std::prev(p.end()));
+    for(auto ins : iterator_for(p))
+    {
+        if(ins->name() != "@param")
+            continue;
+        std::string param = any_cast<builtin::param>(ins->get_operator()).parameter;
+        if(param == "scratch" or param == "memory")
+        {
+            std::size_t n = ctx->buffers.size();
+            ctx->buffers.push_back(allocate_shared(ins->get_shape()));
+            p.replace_instruction(ins, load_memory{ins->get_shape(), n});
+        }
+        // Only replace the output parameter added by lowering, which is what the program returns
+        // and is always written as the last argument
+        else if(param == "output" and last == ins and
+                std::any_of(ins->outputs().begin(), ins->outputs().end(), [&](auto output) {
+                    return output->inputs().back() == ins;
+                }))
+        {
+            p.replace_instruction(ins, allocate{ins->get_shape()});
+        }
+    }
+}
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
@@ -0,0 +1,405 @@
+#include <migraphx/cpu/rnn.hpp>
+#include <migraphx/cpu/gemm.hpp>
+#include <migraphx/cpu/math.hpp>
+#include <migraphx/cpu/convert.hpp>
+#include <migraphx/errors.hpp>
+#include <migraphx/par_for.hpp>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <utility>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+// The sizes of a recurrent operator, where w and r have `gates` blocks of
+// `hidden` rows for each direction
+struct rnn_dims
+{
+    std::size_t seq_len;
+    std::size_t batch;
+    std::size_t input;
+    std::size_t hidden;
+    std::size_t gates;
+    std::size_t dirs;
+
+    std::size_t width() const { return gates * hidden; }
+    std::size_t state() const { return batch * hidden; }
+};
+
+static rnn_dims get_rnn_dims(const std::vector<argument>& args, std::size_t gates)
+{
+    const auto& xl = args[0].get_shape().lens();
+    const auto& rl = args[2].get_shape().lens();
+    return {xl[0], xl[1], xl[2], rl[2], gates, rl[0]};
+}
+
+static bool is_forward(op::rnn_direction direction, std::size_t dir)
+{
+    return direction == op::rnn_direction::forward or
+           (direction == op::rnn_direction::bidirectional and dir == 0);
+}
+
+// A rows x cols matrix whose rows are `stride` values apart
+template <class T>
+static argument matrix(const T* data, std::size_t rows, std::size_t cols, std::size_t stride)
+{
+    return {shape{shape::get_type<T>{}, {rows, cols}, {stride, 1}}, const_cast<T*>(data)};
+}
+
+// The transpose of the standard rows x cols matrix at data
+template <class T>
+static argument transposed(const T* data, std::size_t rows, std::size_t cols)
+{
+    return {shape{shape::get_type<T>{}, {cols, rows}, {1, cols}}, const_cast<T*>(data)};
+}
+
+// An activation function applied to contiguous values. The usual ones are
+// computed directly, and the others through their operator.
+struct rnn_activation
+{
+    operation f;
+    std::string name;
+
+    explicit rnn_activation(operation op) : f(std::move(op)), name(f.name()) {}
+
+    template <class T>
+    void generic(const T* x, T* y, std::size_t n) const
+    {
+        if(name == "sigmoid")
+        {
+            std::transform(x, x + n, y, [](T v) { return T(1) / (T(1) + std::exp(-v)); });
+        }
+        else if(name == "tanh")
+        {
+            std::transform(x, x + n, y, [](T v) { return std::tanh(v); });
+        }
+        else if(name == "relu")
+        {
+            std::transform(x, x + n, y, [](T v) { return std::max(T(0), v); });
+        }
+        else
+        {
+            shape s{shape::get_type<T>{}, {n}};
+            auto r = f.compute(s, {argument{s, const_cast<T*>(x)}});
+            std::copy(r.get<T>().begin(), r.get<T>().end(), y);
+        }
+    }
+
+    template <class T>
+    void operator()(const T* x, T* y, std::size_t n) const
+    {
+        generic(x, y, n);
+    }
+
+    void operator()(const float* x, float* y, std::size_t n) const
+    {
+        if(name == "sigmoid")
+            vector_sigmoid(x, y, n);
+        else if(name == "tanh")
+            vector_tanh(x, y, n);
+        else
+            generic(x, y, n);
+    }
+};
+
+template <class T>
+static const T* data(const argument& a)
+{
+    return reinterpret_cast<const T*>(a.data());
+}
+
+// The input projections x * w^T + bias of every step of direction `dir`,
+// with one row of `width` values for each step and batch
+template <class T>
+static std::vector<T> project(const std::vector<argument>& inputs,
+                              const std::vector<T>& bias,
+                              const rnn_dims& d,
+                              std::size_t dir,
+                              accumulate acc)
+{
+    const std::size_t rows  = d.seq_len * d.batch;
+    const std::size_t width = bias.size();
+    const T* x              = data<T>(inputs[0]);
+    const T* w              = data<T>(inputs[1]) + dir * width * d.input;
+    std::vector<T> p(rows * width);
+    migemm(matrix(p.data(), rows, width, width),
+           matrix(x, rows, d.input, d.input),
+           transposed(w, width, d.input),
+           1.0f,
+           0.0f,
+           acc);
+    par_for(rows, 64, [&](std::size_t i) {
+        std::transform(
+            bias.begin(), bias.end(), p.data() + i * width, p.data() + i * width, std::plus<T>{});
+    });
+    return p;
+}
+
+// Pack the transpose of `rows` rows of r, which are multiplied by the hidden
+// state on every step
+template <class T>
+static argument pack_recurrent(const T* r, std::size_t rows, std::size_t hidden, accumulate acc)
+{
+    return pack_gemm_operand(transposed(r, rows, hidden), gemm_operand::b, acc);
+}
+
+// s = h * r^T for the packed r, where s has `cols` columns and rows `stride`
+// values apart
+template <class T>
+static void recurrent(T* s,
+                      std::size_t stride,
+                      std::size_t cols,
+                      const T* h,
+                      const argument& packed,
+                      const rnn_dims& d,
+                      accumulate acc)
+{
+    migemm_packed(matrix(s, d.batch, cols, stride),
+                  matrix(h, d.batch, d.hidden, d.hidden),
+                  packed,
+                  gemm_operand::b,
+                  1.0f,
+                  0.0f,
+                  acc);
+}
+
+// Call f with the outputs and the inputs in the type they are computed in,
+// which is float for half values
+template <class F>
+static void
+visit_rnn(const std::vector<argument>& outputs, const std::vector<argument>& inputs, F f)
+{
+    const auto type = outputs.front().get_shape().type();
+    if(type == shape::half_type)
+    {
+        std::vector<argument> float_outputs;
+        std::vector<argument> float_inputs;
+        std::transform(outputs.begin(),
+                       outputs.end(),
+                       std::back_inserter(float_outputs),
+                       [](const argument& a) {
+                           return argument{shape{shape::float_type, a.get_shape().lens()}};
+                       });
+        std::transform(inputs.begin(), inputs.end(), std::back_inserter(float_inputs), to_float);
+        f(float_outputs, float_inputs, float{});
+        for(std::size_t i = 0; i < outputs.size(); i++)
+            from_float(outputs[i], float_outputs[i]);
+    }
+    else if(type == shape::float_type)
+    {
+        f(outputs, inputs, float{});
+    }
+    else if(type == shape::double_type)
+    {
+        f(outputs, inputs, double{});
+    }
+    else
+    {
+        MIGRAPHX_THROW("RNN: Only float, half and double values are supported");
+    }
+}
+
+void rnn(const argument& result,
+         const std::vector<argument>& args,
+         const op::rnn& op,
+         accumulate acc)
+{
+    visit_rnn({result}, args, [&](const auto& outputs, const auto& inputs, auto zero) {
+        using type   = decltype(zero);
+        const auto d = get_rnn_dims(inputs, 1);
+        auto* y      = reinterpret_cast<type*>(outputs[0].data());
+        // The directions are independent, so they are computed in parallel
+        par_for(d.dirs, 1, [&](std::size_t dir) {
+            const std::size_t hs    = d.hidden;
+            const std::size_t width = d.width();
+            const type* b           = data<type>(inputs[3]) + dir * 2 * width;
+            std::vector<type> bias(width);
+            std::transform(b, b + width, b + width, bias.begin(), std::plus<type>{});
+            auto p = project(inputs, bias, d, dir, acc);
+            auto r = pack_recurrent(data<type>(inputs[2]) + dir * width * hs, width, hs, acc);
+            rnn_activation f{op.actv_funcs.at(dir)};
+            std::vector<type> s(d.batch * width);
+            const type* h = data<type>(inputs[4]) + dir * d.state();
+            for(std::size_t i = 0; i < d.seq_len; i++)
+            {
+                const std::size_t t = is_forward(op.direction, dir) ? i : d.seq_len - 1 - i;
+                const type* pt      = p.data() + t * d.batch * width;
+                type* out           = y + (t * d.dirs + dir) * d.state();
+                recurrent(s.data(), width, width, h, r, d, acc);
+                std::transform(s.begin(), s.end(), pt, s.begin(), std::plus<type>{});
+                f(s.data(), out, s.size());
+                h = out;
+            }
+        });
+    });
+}
+
+void gru(const argument& result,
+         const std::vector<argument>& args,
+         const op::gru& op,
+         accumulate acc)
+{
+    visit_rnn({result}, args, [&](const auto& outputs, const auto& inputs, auto zero) {
+        using type   = decltype(zero);
+        const auto d = get_rnn_dims(inputs, 3);
+        auto* y      = reinterpret_cast<type*>(outputs[0].data());
+        const bool linear_before_reset = op.linear_before_reset != 0;
+        par_for(d.dirs, 1, [&](std::size_t dir) {
+            const std::size_t hs    = d.hidden;
+            const std::size_t width = d.width();
+            // The gates are z, r and h. The recurrent bias of h is multiplied
+            // by r when the reset is applied after the linear transform.
+            const type* wb = data<type>(inputs[3]) + dir * 2 * width;
+            const type* rb = wb + width;
+            std::vector<type> bias(wb, wb + width);
+            const std::size_t nrb = (linear_before_reset ? 2 : 3) * hs;
+            std::transform(rb, rb + nrb, bias.begin(), bias.begin(), std::plus<type>{});
+            auto p = project(inputs, bias, d, dir, acc);
+            const type* r = data<type>(inputs[2]) + dir * width * hs;
+            // Without the linear transform first, r * h is multiplied by the
+            // rows of h on its own
+            auto r_zr = pack_recurrent(r, linear_before_reset ? width : 2 * hs, hs, acc);
+            auto r_h =
+                linear_before_reset ? argument{} : pack_recurrent(r + 2 * hs * hs, hs, hs, acc);
+            rnn_activation f{op.actv_funcs.at(2 * dir)};
+            rnn_activation g{op.actv_funcs.at(2 * dir + 1)};
+            std::vector<type> s(d.batch * width);
+            std::vector<type> a(d.batch * width);
+            std::vector<type> rh(d.state());
+            const type* h = data<type>(inputs[4]) + dir * d.state();
+            for(std::size_t i = 0; i < d.seq_len; i++)
+            {
+                const std::size_t t = is_forward(op.direction, dir) ? i : d.seq_len - 1 - i;
+                const type* pt      = p.data() + t * d.batch * width;
+                type* out           = y + (t * d.dirs + dir) * d.state();
+                recurrent(s.data(), width, linear_before_reset ? width : 2 * hs, h, r_zr, d, acc);
+                for(std::size_t n = 0; n < d.batch; n++)
+                {
+                    type* sn       = s.data() + n * width;
+                    const type* pn = pt + n * width;
+                    std::transform(sn, sn + 2 * hs, pn, sn, std::plus<type>{});
+                    f(sn, a.data() + n * width, 2 * hs);
+                }
+                if(linear_before_reset)
+                {
+                    for(std::size_t n = 0; n < d.batch; n++)
+                    {
+                        type* sh       = s.data() + n * width + 2 * hs;
+                        const type* an = a.data() + n * width + hs;
+                        const type* pn = pt + n * width + 2 * hs;
+                        for(std::size_t j = 0; j < hs; j++)
+                            sh[j] = pn[j] + an[j] * (sh[j] + rb[2 * hs + j]);
+                    }
+                }
+                else
+                {
+                    for(std::size_t n = 0; n < d.batch; n++)
+                    {
+                        const type* an = a.data() + n * width + hs;
+                        for(std::size_t j = 0; j < hs; j++)
+                            rh[n * hs + j] = an[j] * h[n * hs + j];
+                    }
+                    recurrent(s.data() + 2 * hs, width, hs, rh.data(), r_h, d, acc);
+                    for(std::size_t n = 0; n < d.batch; n++)
+                    {
+                        type* sh       = s.data() + n * width + 2 * hs;
+                        const type* pn = pt + n * width + 2 * hs;
+                        std::transform(sh, sh + hs, pn, sh, std::plus<type>{});
+                    }
+                }
+                // Ht = (1 - zt) (.) ht + zt (.) Ht-1
+                for(std::size_t n = 0; n < d.batch; n++)
+                {
+                    type* an = a.data() + n * width;
+                    g(s.data() + n * width + 2 * hs, an + 2 * hs, hs);
+                    for(std::size_t j = 0; j < hs; j++)
+                    {
+                        const type z   = an[j];
+                        out[n * hs + j] = (type(1) - z) * an[2 * hs + j] + z * h[n * hs + j];
+                    }
+                }
+                h = out;
+            }
+        });
+    });
+}
+
+void lstm(const argument& result,
+          const argument& cell,
+          const std::vector<argument>& args,
+          const op::lstm& op,
+          accumulate acc)
+{
+    visit_rnn({result, cell}, args, [&](const auto& outputs, const auto& inputs, auto zero) {
+        using type   = decltype(zero);
+        const auto d = get_rnn_dims(inputs, 4);
+        auto* y      = reinterpret_cast<type*>(outputs[0].data());
+        auto* cy     = reinterpret_cast<type*>(outputs[1].data());
+        par_for(d.dirs, 1, [&](std::size_t dir) {
+            const std::size_t hs    = d.hidden;
+            const std::size_t width = d.width();
+            // The gates are i, o, f and c
+            const type* b = data<type>(inputs[3]) + dir * 2 * width;
+            std::vector<type> bias(width);
+            std::transform(b, b + width, b + width, bias.begin(), std::plus<type>{});
+            auto p = project(inputs, bias, d, dir, acc);
+            auto r = pack_recurrent(data<type>(inputs[2]) + dir * width * hs, width, hs, acc);
+            const type* pi = data<type>(inputs[6]) + dir * 3 * hs;
+            const type* po = pi + hs;
+            const type* pf = pi + 2 * hs;
+            rnn_activation f{op.actv_funcs.at(3 * dir)};
+            rnn_activation g{op.actv_funcs.at(3 * dir + 1)};
+            rnn_activation hf{op.actv_funcs.at(3 * dir + 2)};
+            std::vector<type> s(d.batch * width);
+            std::vector<type> a(d.batch * width);
+            const type* h = data<type>(inputs[4]) + dir * d.state();
+            // The cell state is updated in place
+            type* c = cy + dir * d.state();
+            const type* ic = data<type>(inputs[5]) + dir * d.state();
+            std::copy(ic, ic + d.state(), c);
+            for(std::size_t i = 0; i < d.seq_len; i++)
+            {
+                const std::size_t t = is_forward(op.direction, dir) ? i : d.seq_len - 1 - i;
+                const type* pt      = p.data() + t * d.batch * width;
+                type* out           = y + (t * d.dirs + dir) * d.state();
+                recurrent(s.data(), width, width, h, r, d, acc);
+                for(std::size_t n = 0; n < d.batch; n++)
+                {
+                    type* sn       = s.data() + n * width;
+                    type* an       = a.data() + n * width;
+                    type* cn       = c + n * hs;
+                    const type* pn = pt + n * width;
+                    std::transform(sn, sn + width, pn, sn, std::plus<type>{});
+                    for(std::size_t j = 0; j < hs; j++)
+                    {
+                        sn[j] += pi[j] * cn[j];
+                        sn[2 * hs + j] += pf[j] * cn[j];
+                    }
+                    f(sn, an, hs);
+                    f(sn + 2 * hs, an + 2 * hs, hs);
+                    g(sn + 3 * hs, an + 3 * hs, hs);
+                    // Ct = ft (.) Ct-1 + it (.) ct, and the output gate looks
+                    // at the new cell state
+                    for(std::size_t j = 0; j < hs; j++)
+                    {
+                        cn[j] = an[2 * hs + j] * cn[j] + an[j] * an[3 * hs + j];
+                        sn[hs + j] += po[j] * cn[j];
+                    }
+                    f(sn + hs, an + hs, hs);
+                    // Ht = ot (.) h(Ct)
+                    hf(cn, sn, hs);
+                    for(std::size_t j = 0; j < hs; j++)
+                        out[n * hs + j] = an[hs + j] * sn[j];
+                }
+                h = out;
+            }
+        });
+    });
+}
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
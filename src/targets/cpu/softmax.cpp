@@ -0,0 +1,271 @@
+#include <migraphx/cpu/softmax.hpp>
+#include <migraphx/cpu/math.hpp>
+#include <migraphx/cpu/convert.hpp>
+#include <migraphx/par_for.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+namespace cpu {
+
+// The input viewed as [outer, n, inner], normalized along n
+struct softmax_dims
+{
+    std::size_t outer;
+    std::size_t n;
+    std::size_t inner;
+};
+
+static std::size_t
+product(const std::vector<std::size_t>& lens, std::size_t first, std::size_t last)
+{
+    return std::accumulate(
+        lens.begin() + first, lens.begin() + last, std::size_t{1}, std::multiplies<std::size_t>{});
+}
+
+// The number of values each task should at least normalize
+const std::size_t softmax_grain = 16384;
+
+// The number of positions along the inner dimensions normalized together
+const std::size_t softmax_block = 256;
+
+template <class T>
+MIGRAPHX_CPU_INLINE T exp_value(T x)
+{
+    return T(std::exp(x));
+}
+
+MIGRAPHX_CPU_INLINE float exp_value(float x) { return fast_exp(x); }
+
+template <bool Log, class T>
+MIGRAPHX_CPU_INLINE void softmax_rows_impl(const T* x, T* y, std::size_t rows, std::size_t n)
+{
+    // Independent partial results, so the reductions can be vectorized
+    constexpr std::size_t lanes = 8;
+    for(std::size_t row = 0; row < rows; row++, x += n, y += n)
+    {
+        std::array<T, lanes> m;
+        m.fill(std::numeric_limits<T>::lowest());
+        std::size_t i = 0;
+        for(; i + lanes <= n; i += lanes)
+        {
+            for(std::size_t l = 0; l < lanes; l++)
+                m[l] = std::max(m[l], x[i + l]);
+        }
+        for(; i < n; i++)
+            m[0] = std::max(m[0], x[i]);
+        const T mx = *std::max_element(m.begin(), m.end());
+
+        std::array<T, lanes> s;
+        s.fill(T(0));
+        for(i = 0; i + lanes <= n; i += lanes)
+        {
+            for(std::size_t l = 0; l < lanes; l++)
+            {
+                T e = exp_value(T(x[i + l] - mx));
+                if(not Log)
+                    y[i + l] = e;
+                s[l] += e;
+            }
+        }
+        for(; i < n; i++)
+        {
+            T e = exp_value(T(x[i] - mx));
+            if(not Log)
+                y[i] = e;
+            s[0] += e;
+        }
+        const T sum = std::accumulate(s.begin(), s.end(), T(0));
+
+        if(Log)
+        {
+            const T shift = mx + T(std::log(sum));
+            for(i = 0; i < n; i++)
+                y[i] = x[i] - shift;
+        }
+        else
+        {
+            const T scale = T(1) / sum;
+            for(i = 0; i < n; i++)
+                y[i] *= scale;
+        }
+    }
+}
+
+// Normalize `cols` consecutive positions of the inner dimensions at once,
+// where the values along n are `inner` apart. The scratch holds 2 * cols
+// values.
+template <bool Log, class T>
+MIGRAPHX_CPU_INLINE void softmax_cols_impl(
+    const T* x, T* y, std::size_t n, std::size_t inner, std::size_t cols, T* scratch)
+{
+    T* m = scratch;
+    T* s = scratch + cols;
+    std::fill(m, m + cols, std::numeric_limits<T>::lowest());
+    for(std::size_t c = 0; c < n; c++)
+    {
+        const T* row = x + c * inner;
+        for(std::size_t j = 0; j < cols; j++)
+            m[j] = std::max(m[j], row[j]);
+    }
+    std::fill(s, s + cols, T(0));
+    for(std::size_t c = 0; c < n; c++)
+    {
+        const T* row = x + c * inner;
+        T* out       = y + c * inner;
+        for(std::size_t j = 0; j < cols; j++)
+        {
+            T e = exp_value(T(row[j] - m[j]));
+            if(not Log)
+                out[j] = e;
+            s[j] += e;
+        }
+    }
+    for(std::size_t j = 0; j < cols; j++)
+        s[j] = Log ? T(m[j] + T(std::log(s[j]))) : T(T(1) / s[j]);
+    for(std::size_t c = 0; c < n; c++)
+    {
+        const T* row = x + c * inner;
+        T* out       = y + c * inner;
+        for(std::size_t j = 0; j < cols; j++)
+            out[j] = Log ? T(row[j] - s[j]) : T(out[j] * s[j]);
+    }
+}
+
+template <class T, bool Log>
+static void
+softmax_rows(const T* x, T* y, std::size_t rows, std::size_t n, std::integral_constant<bool, Log>)
+{
+    softmax_rows_impl<Log>(x, y, rows, n);
+}
+
+MIGRAPHX_CPU_TARGETS
+static void softmax_rows(const float* x, float* y, std::size_t rows, std::size_t n, std::false_type)
+{
+    softmax_rows_impl<false>(x, y, rows, n);
+}
+
+MIGRAPHX_CPU_TARGETS
+static void softmax_rows(const float* x, float* y, std::size_t rows, std::size_t n, std::true_type)
+{
+    softmax_rows_impl<true>(x, y, rows, n);
+}
+
+template <class T, bool Log>
+static void softmax_cols(const T* x,
+                         T* y,
+                         std::size_t n,
+                         std::size_t inner,
+                         std::size_t cols,
+                         T* scratch,
+                         std::integral_constant<bool, Log>)
+{
+    softmax_cols_impl<Log>(x, y, n, inner, cols, scratch);
+}
+
+MIGRAPHX_CPU_TARGETS
+static void softmax_cols(const float* x,
+                         float* y,
+                         std::size_t n,
+                         std::size_t inner,
+                         std::size_t cols,
+                         float* scratch,
+                         std::false_type)
+{
+    softmax_cols_impl<false>(x, y, n, inner, cols, scratch);
+}
+
+MIGRAPHX_CPU_TARGETS
+static void softmax_cols(const float* x,
+                         float* y,
+                         std::size_t n,
+                         std::size_t inner,
+                         std::size_t cols,
+                         float* scratch,
+                         std::true_type)
+{
+    softmax_cols_impl<true>(x, y, n, inner, cols, scratch);
+}
+
+template <class T>
+static T* softmax_scratch(std::size_t n)
+{
+    static thread_local std::vector<T> buffer;
+    if(buffer.size() < n)
+        buffer.resize(n);
+    return buffer.data();
+}
+
+template <bool Log>
+static void softmax_impl(const argument& result, const argument& input, softmax_dims d)
+{
+    if(input.get_shape().type() == shape::half_type)
+    {
+        // Compute in float, converting the half values in bulk
+        argument output{shape{shape::float_type, result.get_shape().lens()}};
+        softmax_impl<Log>(output, to_float(input), d);
+        from_float(result, output);
+        return;
+    }
+    if(d.n == 0)
+        return;
+    visit_all(result, input)([&](auto output, auto x) {
+        using type = typename decltype(x)::value_type;
+        std::integral_constant<bool, Log> log_tag{};
+        if(d.inner == 1)
+        {
+            // Each task normalizes a group of contiguous rows
+            const std::size_t rows  = std::max<std::size_t>(softmax_grain / d.n, 1);
+            const std::size_t tasks = (d.outer + rows - 1) / rows;
+            par_for(tasks, 1, [&](std::size_t i) {
+                const std::size_t first = i * rows;
+                softmax_rows(x.data() + first * d.n,
+                             output.data() + first * d.n,
+                             std::min(rows, d.outer - first),
+                             d.n,
+                             log_tag);
+            });
+        }
+        else
+        {
+            const std::size_t blocks = (d.inner + softmax_block - 1) / softmax_block;
+            par_for(d.outer * blocks, 1, [&](std::size_t i) {
+                const std::size_t offset =
+                    (i / blocks) * d.n * d.inner + (i % blocks) * softmax_block;
+                softmax_cols(x.data() + offset,
+                             output.data() + offset,
+                             d.n,
+                             d.inner,
+                             std::min(softmax_block, d.inner - (i % blocks) * softmax_block),
+                             softmax_scratch<type>(2 * softmax_block),
+                             log_tag);
+            });
+        }
+    });
+}
+
+void softmax(const argument& result, const argument& input, std::size_t axis)
+{
+    const auto& lens = input.get_shape().lens();
+    softmax_impl<false>(result,
+                        input,
+                        {product(lens, 0, axis), lens[axis], product(lens, axis + 1, lens.size())});
+}
+
+void logsoftmax(const argument& result, const argument& input, std::size_t axis)
+{
+    const auto& lens = input.get_shape().lens();
+    softmax_impl<true>(
+        result, input, {product(lens, 0, axis), product(lens, axis, lens.size()), 1});
+}
+
+} // namespace cpu
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
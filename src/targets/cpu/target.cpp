@@ -1,25 +1,70 @@
 
 #include <migraphx/cpu/target.hpp>
 #include <migraphx/cpu/lowering.hpp>
+#include <migraphx/cpu/fuse_ops.hpp>
+#include <migraphx/cpu/preallocate_memory.hpp>
+#include <migraphx/cpu/adjust_allocation.hpp>
+#include <migraphx/cpu/concat_cpu_opt.hpp>
 #include <migraphx/pass.hpp>
 #include <migraphx/auto_contiguous.hpp>
-#include <migraphx/rewrite_rnn.hpp>
 #include <migraphx/dead_code_elimination.hpp>
+#include <migraphx/memory_coloring.hpp>
+#include <migraphx/eliminate_allocation.hpp>
+#include <migraphx/eliminate_concat.hpp>
+#include <migraphx/eliminate_contiguous.hpp>
+#include <migraphx/eliminate_identity.hpp>
+#include <migraphx/eliminate_pad.hpp>
+#include <migraphx/fwd_conv_batchnorm_rewrite.hpp>
+#include <migraphx/propagate_constant.hpp>
+#include <migraphx/simplify_algebra.hpp>
 
 namespace migraphx {
 inline namespace MIGRAPHX_INLINE_NS {
 namespace cpu {
 
+std::ostream& operator<<(std::ostream& os, accumulate v)
+{
+    std::vector<std::string> accumulate_str = {"native", "mixed", "double_precision"};
+    os << accumulate_str[static_cast<std::underlying_type<accumulate>::type>(v)];
+    return os;
+}
+
 std::string target::name() const { return "cpu"; }
 
-std::vector<pass> target::get_passes(migraphx::context&) const
+std::vector<pass> target::get_passes(migraphx::context& gctx) const
 {
-    return {rewrite_rnn{},
-            dead_code_elimination{},
-            auto_contiguous{},
-            dead_code_elimination{},
-            lowering{},
-            dead_code_elimination{}};
+    auto& ctx = any_cast<context>(gctx);
+    // clang-format off
+    return
+    {
+        dead_code_elimination{},
+        eliminate_identity{},
+        eliminate_pad{},
+        dead_code_elimination{},
+        fwd_conv_batchnorm_rewrite{},
+        dead_code_elimination{},
+        simplify_algebra{},
+        dead_code_elimination{},
+        propagate_constant{},
+        dead_code_elimination{},
+        auto_contiguous{},
+        dead_code_elimination{},
+        lowering{acc},
+        eliminate_concat{concat_cpu_optimization{}},
+        dead_code_elimination{},
+        eliminate_contiguous{},
+        dead_code_elimination{},
+        adjust_allocation{},
+        dead_code_elimination{},
+        fuse_ops{},
+        dead_code_elimination{},
+        memory_coloring{"cpu::allocate"},
+        dead_code_elimination{},
+        eliminate_allocation{"cpu::allocate"},
+        preallocate_memory{&ctx},
+        dead_code_elimination{}
+    };
+    // clang-format on
 }
 
 } // namespace cpu
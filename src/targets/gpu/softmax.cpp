@@ -7,7 +7,10 @@ namespace gpu {
 
 shape miopen_softmax::compute_shape(const std::vector<shape>& inputs) const
 {
-    check_shapes{inputs, *this}.has(2).standard();
+    check_shapes{inputs, *this}.has(2).standard().only_dims(4);
+    // MIOpen normalizes across the channels
+    if(op.axis != 1)
+        MIGRAPHX_THROW("SOFTMAX: Only the softmax across the channels is supported");
     return op.compute_shape({inputs.at(0)});
 }
 
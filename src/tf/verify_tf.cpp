@@ -17,7 +17,8 @@ template <class F>
 migraphx::argument run_cpu(F f)
 {
     auto p = f();
-    p.compile(migraphx::cpu::target{});
+    // The reference results are accumulated in double
+    p.compile(migraphx::cpu::target{migraphx::cpu::accumulate::double_precision});
     migraphx::program::parameter_map m;
     for(auto&& x : p.get_parameter_shapes())
     {
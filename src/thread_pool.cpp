@@ -0,0 +1,185 @@
+#include <migraphx/thread_pool.hpp>
+#include <migraphx/env.hpp>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <string>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace migraphx {
+inline namespace MIGRAPHX_INLINE_NS {
+
+MIGRAPHX_DECLARE_ENV_VAR(MIGRAPHX_NUM_THREADS)
+MIGRAPHX_DECLARE_ENV_VAR(MIGRAPHX_PIN_THREADS)
+
+// Set for the workers so nested calls run serially instead of waiting on the
+// pool they are running on
+static thread_local bool in_worker = false; // NOLINT
+
+struct thread_pool::job
+{
+    const range_function* f = nullptr;
+    std::size_t n           = 0;
+    std::size_t grainsize   = 1;
+    // Number of workers that may still join the job
+    std::size_t slots = 0;
+    std::atomic<std::size_t> next{0};
+    std::mutex error_mutex;
+    std::exception_ptr error = nullptr;
+
+    void run()
+    {
+        for(;;)
+        {
+            std::size_t start = next.fetch_add(grainsize);
+            if(start >= n)
+                return;
+            try
+            {
+                (*f)(start, std::min(n, start + grainsize));
+            }
+            catch(...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if(error == nullptr)
+                    error = std::current_exception();
+                // Skip the remaining chunks
+                next = n;
+            }
+        }
+    }
+};
+
+static void pin_thread(std::thread& t, std::size_t core)
+{
+#ifdef __linux__
+    auto cores = std::max(std::thread::hardware_concurrency(), 1u);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core % cores, &set);
+    pthread_setaffinity_np(t.native_handle(), sizeof(cpu_set_t), &set);
+#else
+    (void)t;
+    (void)core;
+#endif
+}
+
+thread_pool::thread_pool(std::size_t n, bool pin)
+{
+    for(std::size_t i = 1; i < n; i++)
+    {
+        workers.emplace_back([this] { this->run_worker(); });
+        // The calling thread is left on core 0
+        if(pin)
+            pin_thread(workers.back(), i);
+    }
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    start_cv.notify_all();
+    for(auto&& t : workers)
+        t.join();
+}
+
+std::size_t thread_pool::size() const { return workers.size() + 1; }
+
+void thread_pool::run_worker()
+{
+    in_worker        = true;
+    std::size_t seen = 0;
+    for(;;)
+    {
+        job* j = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start_cv.wait(lock, [&] { return stopping or (current != nullptr and epoch != seen); });
+            if(stopping)
+                return;
+            seen = epoch;
+            if(current->slots == 0)
+                continue;
+            current->slots--;
+            active++;
+            j = current;
+        }
+        j->run();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            active--;
+        }
+        done_cv.notify_all();
+    }
+}
+
+void thread_pool::parallel_for(std::size_t n,
+                               std::size_t grainsize,
+                               std::size_t max_threads,
+                               const range_function& f)
+{
+    if(n == 0)
+        return;
+    grainsize = std::max<std::size_t>(grainsize, 1);
+    if(workers.empty() or max_threads <= 1 or n <= grainsize or in_worker)
+    {
+        f(0, n);
+        return;
+    }
+    // Another thread is using the pool so dont wait for it
+    std::unique_lock<std::mutex> submit(submit_mutex, std::try_to_lock);
+    if(not submit.owns_lock())
+    {
+        f(0, n);
+        return;
+    }
+
+    job j;
+    j.f         = &f;
+    j.n         = n;
+    j.grainsize = grainsize;
+    j.slots     = std::min(max_threads, size()) - 1;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = &j;
+        epoch++;
+    }
+    start_cv.notify_all();
+    j.run();
+    {
+        // Workers that have not started yet wont join the job, so only wait
+        // for the ones that did
+        std::unique_lock<std::mutex> lock(mutex);
+        current = nullptr;
+        done_cv.wait(lock, [&] { return active == 0; });
+    }
+    if(j.error != nullptr)
+        std::rethrow_exception(j.error);
+}
+
+static std::size_t get_num_threads()
+{
+    auto e = env(MIGRAPHX_NUM_THREADS::value());
+    if(not e.empty())
+    {
+        auto n = std::stoul(e.front());
+        if(n > 0)
+            return n;
+    }
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+thread_pool& get_thread_pool()
+{
+    static thread_pool pool{get_num_threads(), enabled(MIGRAPHX_PIN_THREADS{})};
+    return pool;
+}
+
+} // namespace MIGRAPHX_INLINE_NS
+} // namespace migraphx
@@ -1093,4 +1093,58 @@ TEST_CASE(matmul_mm2)
     }
 }
 
+template <class T>
+void matmul_blocked_test()
+{
+    // Sizes that are not multiples of the blocks used by the gemm, with a
+    // transposed B and alpha and beta applied to a C operand
+    const std::size_t batch = 2;
+    const std::size_t m     = 80;
+    const std::size_t n     = 270;
+    const std::size_t k     = 300;
+    std::vector<T> a(batch * m * k);
+    std::vector<T> bt(batch * n * k);
+    std::vector<T> c(batch * m * n);
+    for(std::size_t i = 0; i < a.size(); i++)
+        a[i] = T((i * 7) % 9) - T(4);
+    for(std::size_t i = 0; i < bt.size(); i++)
+        bt[i] = T((i * 5) % 7) - T(3);
+    for(std::size_t i = 0; i < c.size(); i++)
+        c[i] = T(i % 5);
+
+    std::vector<double> gold(c.size());
+    for(std::size_t b = 0; b < batch; b++)
+    {
+        for(std::size_t i = 0; i < m; i++)
+        {
+            for(std::size_t j = 0; j < n; j++)
+            {
+                double s = 0;
+                for(std::size_t kk = 0; kk < k; kk++)
+                    s += double(a[(b * m + i) * k + kk]) * double(bt[(b * n + j) * k + kk]);
+                auto idx  = (b * m + i) * n + j;
+                gold[idx] = 2 * s + 3 * double(c[idx]);
+            }
+        }
+    }
+
+    migraphx::program p;
+    migraphx::shape a_shape{migraphx::shape::get_type<T>{}, {batch, m, k}};
+    migraphx::shape b_shape{migraphx::shape::get_type<T>{}, {batch, n, k}};
+    migraphx::shape c_shape{migraphx::shape::get_type<T>{}, {batch, m, n}};
+    auto al = p.add_literal(migraphx::literal{a_shape, a});
+    auto bl = p.add_literal(migraphx::literal{b_shape, bt});
+    auto cl = p.add_literal(migraphx::literal{c_shape, c});
+    auto tl = p.add_instruction(migraphx::op::transpose{{0, 2, 1}}, bl);
+    p.add_instruction(migraphx::op::dot{2.0f, 3.0f}, al, tl, cl);
+    p.compile(migraphx::cpu::target{});
+    auto result = p.eval({});
+    std::vector<double> results_vector;
+    result.visit([&](auto output) { results_vector.assign(output.begin(), output.end()); });
+    EXPECT(results_vector == gold);
+}
+TEST_CASE_REGISTER(matmul_blocked_test<float>)
+TEST_CASE_REGISTER(matmul_blocked_test<double>)
+TEST_CASE_REGISTER(matmul_blocked_test<int32_t>)
+
 int main(int argc, const char* argv[]) { test::run(argc, argv); }
@@ -1,4 +1,7 @@
+#include <cstdio>
 #include <iostream>
+#include <sstream>
+#include <unordered_map>
 #include <vector>
 #include <migraphx/literal.hpp>
 #include <migraphx/operators.hpp>
@@ -483,6 +486,92 @@ TEST_CASE(batch_norm_inference_test)
     EXPECT(migraphx::verify_range(result_vector, gold));
 }
 
+// Batch norm of an nchw input with the parameters {gamma, bias, mean, variance}
+std::vector<float> batch_norm_gold(const std::vector<float>& x,
+                                   const std::vector<std::size_t>& lens,
+                                   const std::vector<std::vector<float>>& params)
+{
+    std::vector<float> result(x.size());
+    std::size_t hw = lens[2] * lens[3];
+    for(std::size_t i = 0; i < x.size(); i++)
+    {
+        std::size_t c = (i / hw) % lens[1];
+        result[i]     = params[0][c] * (x[i] - params[2][c]) / std::sqrt(params[3][c] + 1.0e-6f) +
+                    params[1][c];
+    }
+    return result;
+}
+
+TEST_CASE(batch_norm_inference_channels_test)
+{
+    migraphx::program p;
+    std::vector<std::size_t> lens = {2, 3, 2, 4};
+    migraphx::shape s{migraphx::shape::float_type, lens};
+    migraphx::shape vars{migraphx::shape::float_type, {3}};
+    std::vector<float> x_data(s.elements());
+    std::iota(x_data.begin(), x_data.end(), -20);
+    std::vector<std::vector<float>> params = {{1, 2, 0.5}, {0, 1, -1}, {-2, 0, 3}, {1, 4, 0.25}};
+
+    auto x = p.add_parameter("x", s);
+    std::vector<migraphx::instruction_ref> args = {x};
+    for(auto&& param : params)
+        args.push_back(p.add_literal(migraphx::literal{vars, param}));
+    p.add_instruction(migraphx::op::batch_norm_inference{}, args);
+    p.compile(migraphx::cpu::target{});
+    auto result = p.eval({{"x", migraphx::argument{s, x_data.data()}}});
+
+    std::vector<float> result_vector;
+    result.visit([&](auto output) { result_vector.assign(output.begin(), output.end()); });
+    EXPECT(migraphx::verify_range(result_vector, batch_norm_gold(x_data, lens, params)));
+}
+
+TEST_CASE(batch_norm_inference_nhwc_test)
+{
+    // The batch norm reads the transposed input, with the channels of each
+    // pixel next to each other, without copying it first
+    migraphx::program p;
+    std::vector<std::size_t> lens = {2, 3, 2, 4};
+    migraphx::shape xs{migraphx::shape::float_type, {2, 2, 4, 3}};
+    migraphx::shape s{migraphx::shape::float_type, lens};
+    migraphx::shape vars{migraphx::shape::float_type, {3}};
+    std::vector<float> x_data(xs.elements());
+    std::iota(x_data.begin(), x_data.end(), -20);
+    std::vector<float> y_data(s.elements(), 1);
+    std::vector<std::vector<float>> params = {{1, 2, 0.5}, {0, 1, -1}, {-2, 0, 3}, {1, 4, 0.25}};
+
+    auto x  = p.add_parameter("x", xs);
+    auto y  = p.add_parameter("y", s);
+    auto xt = p.add_instruction(migraphx::op::transpose{{0, 3, 1, 2}}, x);
+    std::vector<migraphx::instruction_ref> args = {xt};
+    for(auto&& param : params)
+        args.push_back(p.add_literal(migraphx::literal{vars, param}));
+    auto bn = p.add_instruction(migraphx::op::batch_norm_inference{}, args);
+    p.add_instruction(migraphx::op::add{}, bn, y);
+    p.compile(migraphx::cpu::target{});
+    EXPECT(std::none_of(
+        p.begin(), p.end(), [](auto&& ins) { return ins.name() == "cpu::contiguous"; }));
+    migraphx::program::parameter_map m;
+    m["x"]      = migraphx::argument{xs, x_data.data()};
+    m["y"]      = migraphx::argument{s, y_data.data()};
+    auto result = p.eval(m);
+
+    // The input in nchw order
+    std::vector<float> nchw(s.elements());
+    for(std::size_t i = 0; i < nchw.size(); i++)
+    {
+        std::size_t w = i % 4;
+        std::size_t h = (i / 4) % 2;
+        std::size_t c = (i / 8) % 3;
+        std::size_t n = i / 24;
+        nchw[i]       = x_data[((n * 2 + h) * 4 + w) * 3 + c];
+    }
+    auto gold = batch_norm_gold(nchw, lens, params);
+    std::transform(gold.begin(), gold.end(), gold.begin(), [](auto v) { return v + 1; });
+    std::vector<float> result_vector;
+    result.visit([&](auto output) { result_vector.assign(output.begin(), output.end()); });
+    EXPECT(migraphx::verify_range(result_vector, gold));
+}
+
 TEST_CASE(im2col_3x3_with_channels_identity_test)
 {
     std::size_t f[2]    = {3, 3};
@@ -789,6 +878,41 @@ TEST_CASE(lrn_test)
     EXPECT(migraphx::verify_range(results_vector, gold));
 }
 
+TEST_CASE(lrn_window_test)
+{
+    // An even size has one more channel above than below in its window
+    std::vector<std::size_t> lens = {2, 6, 3, 5};
+    migraphx::shape s{migraphx::shape::float_type, lens};
+    std::vector<float> x_data(s.elements());
+    std::iota(x_data.begin(), x_data.end(), -90);
+    std::size_t spatial = lens[2] * lens[3];
+    for(float beta : {0.75f, 0.5f, 1.0f, 0.6f})
+    {
+        migraphx::op::lrn op{0.01, beta, 2, 4};
+        migraphx::program p;
+        auto x = p.add_parameter("x", s);
+        p.add_instruction(op, x);
+        p.compile(migraphx::cpu::target{});
+        auto result = p.eval({{"x", migraphx::argument{s, x_data.data()}}});
+        std::vector<float> results_vector;
+        result.visit([&](auto output) { results_vector.assign(output.begin(), output.end()); });
+
+        std::vector<float> gold(x_data.size());
+        for(std::size_t i = 0; i < x_data.size(); i++)
+        {
+            int c      = (i / spatial) % lens[1];
+            double sum   = 0;
+            for(int k = std::max(c - 1, 0); k <= std::min(c + 2, int(lens[1]) - 1); k++)
+            {
+                double v = x_data[i + (k - c) * spatial];
+                sum += v * v;
+            }
+            gold[i] = x_data[i] / std::pow(op.bias + op.alpha / op.size * sum, beta);
+        }
+        EXPECT(migraphx::verify_range(results_vector, gold));
+    }
+}
+
 TEST_CASE(imagescaler_test)
 {
     migraphx::program p;
@@ -928,6 +1052,99 @@ TEST_CASE(maxpool_test)
     EXPECT(migraphx::verify_range(results_vector, c));
 }
 
+std::vector<float> pooling_gold(const std::vector<float>& x,
+                                const std::vector<std::size_t>& lens,
+                                const migraphx::op::pooling& op)
+{
+    auto out_lens = op.compute_shape({{migraphx::shape::float_type, lens}}).lens();
+    std::vector<float> result;
+    for(std::size_t n = 0; n < lens[0] * lens[1]; n++)
+    {
+        for(std::size_t i = 0; i < out_lens[2]; i++)
+        {
+            for(std::size_t j = 0; j < out_lens[3]; j++)
+            {
+                double acc        = op.mode == "max" ? -1.0e30 : 0;
+                std::size_t count = 0;
+                for(std::size_t a = 0; a < op.lengths[0]; a++)
+                {
+                    for(std::size_t b = 0; b < op.lengths[1]; b++)
+                    {
+                        std::ptrdiff_t h = i * op.stride[0] + a - op.padding[0];
+                        std::ptrdiff_t w = j * op.stride[1] + b - op.padding[1];
+                        if(h < 0 or w < 0 or h >= std::ptrdiff_t(lens[2]) or
+                           w >= std::ptrdiff_t(lens[3]))
+                            continue;
+                        float v = x[(n * lens[2] + h) * lens[3] + w];
+                        acc     = op.mode == "max" ? std::max<double>(acc, v) : acc + v;
+                        count++;
+                    }
+                }
+                result.push_back(op.mode == "max" ? acc : acc / count);
+            }
+        }
+    }
+    return result;
+}
+
+TEST_CASE(pooling_windows_test)
+{
+    std::vector<std::size_t> lens = {2, 3, 7, 9};
+    migraphx::shape s{migraphx::shape::float_type, lens};
+    std::vector<float> x_data(s.elements());
+    for(std::size_t i = 0; i < x_data.size(); i++)
+        x_data[i] = float((i * 37) % 101) - 50;
+    // The same input with the rows and columns swapped in memory, which is
+    // pooled by the generic loop
+    migraphx::shape ts{migraphx::shape::float_type, {2, 3, 9, 7}};
+    std::vector<float> t_data(ts.elements());
+    for(std::size_t i = 0; i < x_data.size(); i++)
+    {
+        std::size_t n               = i / 63;
+        std::size_t h               = (i / 9) % 7;
+        std::size_t w               = i % 9;
+        t_data[(n * 9 + w) * 7 + h] = x_data[i];
+    }
+    // Global, 2x2 and 3x3 with a stride of 2, and other windows
+    std::vector<std::array<std::size_t, 6>> windows = {{{7, 9, 1, 1, 0, 0}},
+                                                       {{2, 2, 2, 2, 0, 0}},
+                                                       {{3, 3, 2, 2, 1, 1}},
+                                                       {{3, 3, 1, 1, 1, 1}},
+                                                       {{5, 4, 3, 2, 2, 1}}};
+    for(std::string mode : {"max", "average"})
+    {
+        for(auto window : windows)
+        {
+            migraphx::op::pooling op{mode};
+            op.lengths = {window[0], window[1]};
+            op.stride  = {window[2], window[3]};
+            op.padding = {window[4], window[5]};
+            auto gold = pooling_gold(x_data, lens, op);
+
+            migraphx::program p1;
+            auto x = p1.add_parameter("x", s);
+            p1.add_instruction(op, x);
+            p1.compile(migraphx::cpu::target{});
+            auto result1 = p1.eval({{"x", migraphx::argument{s, x_data.data()}}});
+            std::vector<float> results_vector1;
+            result1.visit(
+                [&](auto output) { results_vector1.assign(output.begin(), output.end()); });
+            EXPECT(migraphx::verify_range(results_vector1, gold));
+
+            migraphx::program p2;
+            auto t  = p2.add_parameter("t", ts);
+            auto tt = p2.add_instruction(migraphx::op::transpose{{0, 1, 3, 2}}, t);
+            p2.add_instruction(op, tt);
+            p2.compile(migraphx::cpu::target{});
+            auto result2 = p2.eval({{"t", migraphx::argument{ts, t_data.data()}}});
+            std::vector<float> results_vector2;
+            result2.visit(
+                [&](auto output) { results_vector2.assign(output.begin(), output.end()); });
+            EXPECT(migraphx::verify_range(results_vector2, gold));
+        }
+    }
+}
+
 TEST_CASE(softmax_test)
 {
     migraphx::program p;
@@ -987,6 +1204,52 @@ TEST_CASE(softmax_test)
     EXPECT(migraphx::verify_range(results_vector, s));
 }
 
+TEST_CASE(softmax_axis_test)
+{
+    // Large enough for the vectorized loops and several tasks
+    migraphx::shape s{migraphx::shape::float_type, {3, 70, 300}};
+    std::vector<float> data(s.elements());
+    for(std::size_t i = 0; i < data.size(); i++)
+        data[i] = float((i * 37) % 101) / 10 - 5;
+
+    auto run = [&](const migraphx::operation& op) {
+        migraphx::program p;
+        auto x = p.add_parameter("x", s);
+        p.add_instruction(op, x);
+        p.compile(migraphx::cpu::target{});
+        auto result = p.eval({{"x", migraphx::argument{s, data.data()}}});
+        std::vector<float> results_vector;
+        result.visit([&](auto output) { results_vector.assign(output.begin(), output.end()); });
+        return results_vector;
+    };
+    // The input viewed as [outer, n, inner], normalized along n
+    auto gold = [&](std::size_t outer, std::size_t n, std::size_t inner, bool log) {
+        std::vector<float> result(data.size());
+        for(std::size_t o = 0; o < outer; o++)
+        {
+            for(std::size_t j = 0; j < inner; j++)
+            {
+                auto at = [&](std::size_t c) { return (o * n + c) * inner + j; };
+                double m = data[at(0)];
+                for(std::size_t c = 0; c < n; c++)
+                    m = std::max<double>(m, data[at(c)]);
+                double sum = 0;
+                for(std::size_t c = 0; c < n; c++)
+                    sum += std::exp(data[at(c)] - m);
+                for(std::size_t c = 0; c < n; c++)
+                    result[at(c)] = log ? data[at(c)] - m - std::log(sum)
+                                        : std::exp(data[at(c)] - m) / sum;
+            }
+        }
+        return result;
+    };
+    EXPECT(migraphx::verify_range(run(migraphx::op::softmax{0}), gold(1, 3, 21000, false)));
+    EXPECT(migraphx::verify_range(run(migraphx::op::softmax{1}), gold(3, 70, 300, false)));
+    EXPECT(migraphx::verify_range(run(migraphx::op::softmax{2}), gold(210, 300, 1, false)));
+    EXPECT(migraphx::verify_range(run(migraphx::op::logsoftmax{1}), gold(3, 21000, 1, true)));
+    EXPECT(migraphx::verify_range(run(migraphx::op::logsoftmax{2}), gold(210, 300, 1, true)));
+}
+
 TEST_CASE(logsoftmax_test_axis_0)
 {
     migraphx::program p;
@@ -1157,6 +1420,169 @@ TEST_CASE(logsoftmax_test_axis_4)
     EXPECT(migraphx::verify_range(results_vector, s));
 }
 
+TEST_CASE(accumulate_policy_test)
+{
+    migraphx::shape xs{migraphx::shape::float_type, {1, 2, 6, 6}};
+    migraphx::shape ws{migraphx::shape::float_type, {3, 2, 3, 3}};
+    std::vector<float> x_data(xs.elements());
+    std::vector<float> w_data(ws.elements());
+    for(std::size_t i = 0; i < x_data.size(); i++)
+        x_data[i] = float((i * 37) % 23) / 7 - 1.5f;
+    for(std::size_t i = 0; i < w_data.size(); i++)
+        w_data[i] = float((i * 11) % 13) / 5 - 1;
+
+    auto run = [&](migraphx::cpu::accumulate acc) {
+        migraphx::program p;
+        auto x    = p.add_parameter("x", xs);
+        auto w    = p.add_literal(migraphx::literal{ws, w_data});
+        auto conv = p.add_instruction(migraphx::op::convolution{{1, 1}}, x, w);
+        p.add_instruction(migraphx::op::pooling{"average", {1, 1}, {1, 1}, {3, 3}}, conv);
+        p.compile(migraphx::cpu::target{acc});
+        std::stringstream name;
+        name << "accumulate=" << acc;
+        // The kernels are lowered with the policy of the target
+        EXPECT(std::count_if(p.begin(), p.end(), [&](auto&& ins) {
+                   std::stringstream ss;
+                   ss << ins.get_operator();
+                   return ss.str().find(name.str()) != std::string::npos;
+               }) == 2);
+        auto result = p.eval({{"x", migraphx::argument{xs, x_data.data()}}});
+        std::vector<float> results_vector;
+        result.visit([&](auto output) { results_vector.assign(output.begin(), output.end()); });
+        return results_vector;
+    };
+    auto gold = run(migraphx::cpu::accumulate::double_precision);
+    EXPECT(migraphx::verify_range(run(migraphx::cpu::accumulate::native), gold));
+    EXPECT(migraphx::verify_range(run(migraphx::cpu::accumulate::mixed), gold));
+}
+
+TEST_CASE(half_fast_path_test)
+{
+    // Half programs are computed in float, so they match a float program
+    // on the same values to the precision of half
+    auto make_program = [](migraphx::shape::type_t t) {
+        migraphx::program p;
+        auto x    = p.add_parameter("x", migraphx::shape{t, {1, 4, 6, 6}});
+        auto w    = p.add_parameter("w", migraphx::shape{t, {4, 4, 3, 3}});
+        auto b    = p.add_parameter("b", migraphx::shape{t, {1, 4, 6, 6}});
+        auto m    = p.add_parameter("m", migraphx::shape{t, {9, 4}});
+        auto conv = p.add_instruction(migraphx::op::convolution{{1, 1}}, x, w);
+        auto add  = p.add_instruction(migraphx::op::add{}, conv, b);
+        auto relu = p.add_instruction(migraphx::op::relu{}, add);
+        auto pool =
+            p.add_instruction(migraphx::op::pooling{"max", {0, 0}, {2, 2}, {2, 2}}, relu);
+        auto r = p.add_instruction(migraphx::op::reshape{{4, 9}}, pool);
+        p.add_instruction(migraphx::op::dot{}, r, m);
+        p.compile(migraphx::cpu::target{});
+        return p;
+    };
+    auto pf = make_program(migraphx::shape::float_type);
+    auto ph = make_program(migraphx::shape::half_type);
+    EXPECT(std::none_of(ph.begin(), ph.end(), [](auto&& ins) {
+        return ins.name() == "cpu::add" or ins.name() == "cpu::relu";
+    }));
+
+    std::unordered_map<std::string, std::vector<float>> float_data;
+    std::unordered_map<std::string, std::vector<migraphx::half>> half_data;
+    migraphx::program::parameter_map float_params;
+    migraphx::program::parameter_map half_params;
+    for(auto&& x : pf.get_parameter_shapes())
+    {
+        if(x.first == "output")
+            continue;
+        auto& fd = float_data[x.first];
+        auto& hd = half_data[x.first];
+        for(std::size_t i = 0; i < x.second.elements(); i++)
+        {
+            hd.push_back(migraphx::half(float((i * 29 + x.first.size()) % 17) / 8 - 1));
+            fd.push_back(float(hd.back()));
+        }
+        float_params[x.first] = migraphx::argument{x.second, fd.data()};
+        half_params[x.first]  = migraphx::argument{
+            migraphx::shape{migraphx::shape::half_type, x.second.lens()}, hd.data()};
+    }
+    std::vector<float> gold;
+    pf.eval(float_params).visit([&](auto output) { gold.assign(output.begin(), output.end()); });
+    std::vector<float> results_vector;
+    ph.eval(half_params).visit(
+        [&](auto output) { results_vector.assign(output.begin(), output.end()); });
+    EXPECT(migraphx::verify_range(results_vector, gold, 4.0e4));
+}
+
+TEST_CASE(packed_weights_test)
+{
+    // Constant weights are packed when the program is compiled, and give the
+    // same results as the same weights passed as parameters
+    auto values = [](std::size_t n, std::size_t seed) {
+        std::vector<float> v(n);
+        for(std::size_t i = 0; i < n; i++)
+            v[i] = float((i * 37 + seed) % 23) / 11 - 1;
+        return v;
+    };
+    auto make_program = [&](migraphx::shape::type_t t, bool constant) {
+        migraphx::program p;
+        migraphx::shape ws{t, {8, 3, 3, 3}};
+        migraphx::shape ms{t, {37, 72}};
+        auto x   = p.add_parameter("x", migraphx::shape{t, {2, 6, 5, 5}});
+        auto y   = p.add_parameter("y", migraphx::shape{t, {5, 72}});
+        auto w   = constant ? p.add_literal(migraphx::literal{ws, values(ws.elements(), 1)})
+                            : p.add_parameter("w", ws);
+        auto m   = constant ? p.add_literal(migraphx::literal{ms, values(ms.elements(), 2)})
+                            : p.add_parameter("m", ms);
+        auto mt  = p.add_instruction(migraphx::op::transpose{{1, 0}}, m);
+        auto c   = p.add_instruction(
+            migraphx::op::convolution{{{1, 1}}, {{1, 1}}, {{1, 1}}, migraphx::op::default_, 2},
+            x,
+            w);
+        auto d   = p.add_instruction(migraphx::op::dot{0.5f, 0.0f}, y, mt);
+        auto cr  = p.add_instruction(migraphx::op::reshape{{2, 200}}, c);
+        auto dr  = p.add_instruction(migraphx::op::reshape{{1, 185}}, d);
+        auto crs = p.add_instruction(migraphx::op::slice{{1}, {0}, {185}}, cr);
+        p.add_instruction(migraphx::op::concat{0}, crs, dr);
+        p.compile(migraphx::cpu::target{});
+        return p;
+    };
+    for(auto t : {migraphx::shape::float_type, migraphx::shape::half_type})
+    {
+        auto pc = make_program(t, true);
+        auto pp = make_program(t, false);
+        // The original weights are replaced by their packed panels
+        EXPECT(std::none_of(pc.begin(), pc.end(), [](auto&& ins) {
+            return ins.name() == "@literal" and ins.get_shape().lens().size() > 1;
+        }));
+
+        std::unordered_map<std::string, std::vector<float>> float_data;
+        std::unordered_map<std::string, std::vector<migraphx::half>> half_data;
+        migraphx::program::parameter_map params;
+        for(auto&& x : pp.get_parameter_shapes())
+        {
+            if(x.first == "output")
+                continue;
+            auto v = values(x.second.elements(), x.first == "w" ? 1 : x.first == "m" ? 2 : 3);
+            if(t == migraphx::shape::half_type)
+            {
+                auto& hd = half_data[x.first];
+                hd.assign(v.begin(), v.end());
+                params[x.first] = migraphx::argument{x.second, hd.data()};
+            }
+            else
+            {
+                auto& fd        = float_data[x.first];
+                fd              = v;
+                params[x.first] = migraphx::argument{x.second, fd.data()};
+            }
+        }
+        std::vector<float> gold;
+        pp.eval(params).visit([&](auto output) { gold.assign(output.begin(), output.end()); });
+        params.erase("w");
+        params.erase("m");
+        std::vector<float> results_vector;
+        pc.eval(params).visit(
+            [&](auto output) { results_vector.assign(output.begin(), output.end()); });
+        EXPECT(migraphx::verify_range(results_vector, gold));
+    }
+}
+
 TEST_CASE(conv2d_test)
 {
     migraphx::program p;
@@ -1337,6 +1763,50 @@ TEST_CASE(conv2d_padding_stride_test)
     EXPECT(migraphx::verify_range(results_vector, s));
 }
 
+template <class T>
+std::vector<float> run_conv(migraphx::op::convolution op,
+                             std::vector<std::size_t> input_lens,
+                             std::vector<std::size_t> weights_lens)
+{
+    // float uses the gemm convolution and double uses the direct loop
+    migraphx::program p;
+    migraphx::shape a_shape{migraphx::shape::get_type<T>{}, input_lens};
+    migraphx::shape c_shape{migraphx::shape::get_type<T>{}, weights_lens};
+    std::vector<T> a(a_shape.elements());
+    std::vector<T> c(c_shape.elements());
+    for(std::size_t i = 0; i < a.size(); i++)
+        a[i] = T((i * 7) % 13) / 4 - 1;
+    for(std::size_t i = 0; i < c.size(); i++)
+        c[i] = T((i * 5) % 11) / 8 - 0.5;
+    auto al = p.add_literal(migraphx::literal{a_shape, a});
+    auto cl = p.add_literal(migraphx::literal{c_shape, c});
+    p.add_instruction(op, al, cl);
+    p.compile(migraphx::cpu::target{});
+    auto result = p.eval({});
+    std::vector<float> results_vector;
+    result.visit([&](auto output) { results_vector.assign(output.begin(), output.end()); });
+    return results_vector;
+}
+
+TEST_CASE(conv2d_gemm_test)
+{
+    auto check = [](migraphx::op::convolution op,
+                    std::vector<std::size_t> input_lens,
+                    std::vector<std::size_t> weights_lens) {
+        auto gemm   = run_conv<float>(op, input_lens, weights_lens);
+        auto direct = run_conv<double>(op, input_lens, weights_lens);
+        EXPECT(gemm.size() == direct.size());
+        EXPECT(migraphx::verify_range(gemm, direct, 1000));
+    };
+    check(migraphx::op::convolution{}, {2, 3, 5, 5}, {4, 3, 3, 3});
+    check(migraphx::op::convolution{{{1, 0}}, {{2, 1}}}, {2, 3, 7, 6}, {4, 3, 3, 2});
+    check(migraphx::op::convolution{{{2, 2}}, {{1, 1}}, {{2, 2}}}, {1, 2, 6, 6}, {3, 2, 3, 3});
+    check(migraphx::op::convolution{{{1, 1}}, {{1, 1}}, {{1, 1}}, migraphx::op::default_, 2},
+          {2, 4, 5, 5},
+          {6, 2, 3, 3});
+    check(migraphx::op::convolution{}, {2, 8, 4, 4}, {5, 8, 1, 1});
+}
+
 TEST_CASE(transpose_test)
 {
     migraphx::shape a_shape{migraphx::shape::float_type, {1, 2, 2, 3}};
@@ -1476,6 +1946,65 @@ TEST_CASE(tanh_test)
     EXPECT(migraphx::verify_range(results_vector, gold));
 }
 
+TEST_CASE(erf_test)
+{
+    migraphx::program p;
+    migraphx::shape s{migraphx::shape::float_type, {2, 2}};
+    auto l = p.add_literal(migraphx::literal{s, {-1.5, 0.25, 0.75, 3.0}});
+    p.add_instruction(migraphx::op::erf{}, l);
+    p.compile(migraphx::cpu::target{});
+    auto result = p.eval({});
+    std::vector<float> results_vector(4);
+    result.visit([&](auto output) { results_vector.assign(output.begin(), output.end()); });
+    std::vector<float> gold{erff(-1.5), erff(0.25), erff(0.75), erff(3.0)};
+    EXPECT(migraphx::verify_range(results_vector, gold));
+}
+
+TEST_CASE(unary_vector_test)
+{
+    // Large enough for several tasks, with inputs past the range of the
+    // vectorized sine and cosine
+    migraphx::shape s{migraphx::shape::float_type, {5, 10000}};
+    std::vector<float> data(s.elements());
+    for(std::size_t i = 0; i < data.size(); i++)
+        data[i] = float((i * 37) % 1001) / 50 - 10;
+    std::vector<float> wide = data;
+    wide[7]                 = 3000.0f;
+    wide[11]                = -1.0e6f;
+
+    auto run = [&](const migraphx::operation& op, const std::vector<float>& x) {
+        migraphx::program p;
+        auto l = p.add_literal(migraphx::literal{s, x});
+        p.add_instruction(op, l);
+        p.compile(migraphx::cpu::target{});
+        auto result = p.eval({});
+        std::vector<float> results_vector;
+        result.visit([&](auto output) { results_vector.assign(output.begin(), output.end()); });
+        return results_vector;
+    };
+    auto gold = [&](const std::vector<float>& x, float (*f)(float)) {
+        std::vector<float> result(x.size());
+        std::transform(x.begin(), x.end(), result.begin(), f);
+        return result;
+    };
+    std::vector<float> positive(data.size());
+    std::transform(data.begin(), data.end(), positive.begin(), [](float x) {
+        return std::abs(x) + 1.0e-3f;
+    });
+    EXPECT(migraphx::verify_range(run(migraphx::op::exp{}, data), gold(data, expf)));
+    EXPECT(migraphx::verify_range(run(migraphx::op::log{}, positive), gold(positive, logf)));
+    EXPECT(migraphx::verify_range(run(migraphx::op::tanh{}, data), gold(data, tanhf)));
+    EXPECT(migraphx::verify_range(run(migraphx::op::erf{}, data), gold(data, erff)));
+    EXPECT(migraphx::verify_range(run(migraphx::op::sin{}, wide), gold(wide, sinf)));
+    EXPECT(migraphx::verify_range(run(migraphx::op::cos{}, wide), gold(wide, cosf)));
+    EXPECT(migraphx::verify_range(run(migraphx::op::sigmoid{}, data), gold(data, [](float x) {
+                                      return 1.0f / (1.0f + std::exp(-x));
+                                  })));
+    EXPECT(migraphx::verify_range(run(migraphx::op::elu{0.5f}, data), gold(data, [](float x) {
+                                      return x > 0 ? x : 0.5f * std::expm1(x);
+                                  })));
+}
+
 TEST_CASE(elu_test)
 {
     migraphx::program p;
@@ -1574,4 +2103,273 @@ TEST_CASE(clip_test)
     EXPECT(migraphx::verify_range(results_vector, gold));
 }
 
+TEST_CASE(memory_plan_test)
+{
+    migraphx::program p;
+    migraphx::shape s{migraphx::shape::float_type, {4}};
+    auto x   = p.add_parameter("x", s);
+    auto sum = p.add_instruction(migraphx::op::add{}, x, x);
+    auto r   = p.add_instruction(migraphx::op::relu{}, sum);
+    p.add_instruction(migraphx::op::mul{}, r, x);
+    p.compile(migraphx::cpu::target{});
+    // Only the output is allocated on every eval
+    EXPECT(std::count_if(p.begin(), p.end(), [](auto&& ins) {
+               return ins.name() == "cpu::allocate";
+           }) == 1);
+
+    auto run = [&](std::vector<float> data) {
+        return p.eval({{"x", migraphx::argument{s, data.data()}}});
+    };
+    auto result1 = run({-1, 0, 1, 2});
+    auto result2 = run({1, 2, 3, 4});
+    std::vector<float> results_vector1;
+    result1.visit([&](auto output) { results_vector1.assign(output.begin(), output.end()); });
+    std::vector<float> results_vector2;
+    result2.visit([&](auto output) { results_vector2.assign(output.begin(), output.end()); });
+    std::vector<float> gold1 = {0, 0, 2, 8};
+    std::vector<float> gold2 = {2, 8, 18, 32};
+    EXPECT(migraphx::verify_range(results_vector1, gold1));
+    EXPECT(migraphx::verify_range(results_vector2, gold2));
+}
+
+TEST_CASE(fused_pointwise_test)
+{
+    migraphx::program p;
+    migraphx::shape s{migraphx::shape::float_type, {2, 3}};
+    migraphx::shape bs{migraphx::shape::float_type, {3}};
+    std::vector<float> data = {-3, -2, -1, 0, 1, 2};
+    auto x   = p.add_parameter("x", s);
+    auto xt  = p.add_instruction(migraphx::op::transpose{{1, 0}}, x);
+    auto y   = p.add_parameter("y", {migraphx::shape::float_type, {3, 2}});
+    auto b   = p.add_literal(migraphx::literal{bs, {1, 2, 3}});
+    auto bb  = p.add_instruction(migraphx::op::broadcast{0, {3, 2}}, b);
+    auto sum = p.add_instruction(migraphx::op::add{}, xt, bb);
+    auto r   = p.add_instruction(migraphx::op::relu{}, sum);
+    p.add_instruction(migraphx::op::mul{}, r, y);
+    p.compile(migraphx::cpu::target{});
+    EXPECT(std::count_if(p.begin(), p.end(), [](auto&& ins) {
+               return ins.name() == "cpu::fused_pointwise";
+           }) == 1);
+    EXPECT(std::none_of(p.begin(), p.end(), [](auto&& ins) {
+        return ins.name() == "cpu::add" or ins.name() == "cpu::relu";
+    }));
+
+    std::vector<float> ydata = {1, 2, 3, 4, 5, 6};
+    auto result = p.eval({{"x", migraphx::argument{s, data.data()}},
+                          {"y", migraphx::argument{y->get_shape(), ydata.data()}}});
+    std::vector<float> results_vector;
+    result.visit([&](auto output) { results_vector.assign(output.begin(), output.end()); });
+    std::vector<float> gold = {0, 2, 0, 12, 10, 30};
+    EXPECT(migraphx::verify_range(results_vector, gold));
+}
+
+TEST_CASE(fused_pointwise_chunks_test)
+{
+    // Enough elements to be split into several chunks
+    migraphx::program p;
+    migraphx::shape s{migraphx::shape::float_type, {3, 2500}};
+    std::vector<float> data(s.elements());
+    std::iota(data.begin(), data.end(), -3000);
+    std::transform(data.begin(), data.end(), data.begin(), [](auto x) { return x / 1000; });
+    auto x   = p.add_parameter("x", s);
+    auto y   = p.add_instruction(migraphx::op::mul{}, x, x);
+    auto sum = p.add_instruction(migraphx::op::add{}, y, x);
+    p.add_instruction(migraphx::op::sigmoid{}, sum);
+    p.compile(migraphx::cpu::target{});
+    auto result = p.eval({{"x", migraphx::argument{s, data.data()}}});
+    std::vector<float> results_vector;
+    result.visit([&](auto output) { results_vector.assign(output.begin(), output.end()); });
+    std::vector<float> gold(data.size());
+    std::transform(data.begin(), data.end(), gold.begin(), [](auto x) {
+        return 1.f / (1.f + std::exp(-(x * x + x)));
+    });
+    EXPECT(migraphx::verify_range(results_vector, gold));
+}
+
+TEST_CASE(concat_elimination_test)
+{
+    // The inputs are written directly into the output of the concat
+    migraphx::program p;
+    migraphx::shape xs{migraphx::shape::float_type, {1, 3}};
+    migraphx::shape ys{migraphx::shape::float_type, {2, 3}};
+    auto x  = p.add_parameter("x", xs);
+    auto y  = p.add_parameter("y", ys);
+    auto rx = p.add_instruction(migraphx::op::relu{}, x);
+    auto ny = p.add_instruction(migraphx::op::neg{}, y);
+    auto c  = p.add_instruction(migraphx::op::concat{0}, rx, ny);
+    p.add_instruction(migraphx::op::abs{}, c);
+    p.compile(migraphx::cpu::target{});
+    EXPECT(std::none_of(
+        p.begin(), p.end(), [](auto&& ins) { return ins.name() == "cpu::concat"; }));
+
+    std::vector<float> xdata = {-1, 2, -3};
+    std::vector<float> ydata = {4, -5, 6, -7, 8, -9};
+    migraphx::program::parameter_map m;
+    m["x"]      = migraphx::argument{xs, xdata.data()};
+    m["y"]      = migraphx::argument{ys, ydata.data()};
+    auto result = p.eval(m);
+    std::vector<float> results_vector;
+    result.visit([&](auto output) { results_vector.assign(output.begin(), output.end()); });
+    std::vector<float> gold = {0, 2, 0, 4, 5, 6, 7, 8, 9};
+    EXPECT(migraphx::verify_range(results_vector, gold));
+}
+
+TEST_CASE(contiguous_elimination_test)
+{
+    // The relu reads the transposed input without a copy
+    migraphx::program p;
+    migraphx::shape s{migraphx::shape::float_type, {2, 3}};
+    auto x  = p.add_parameter("x", s);
+    auto xt = p.add_instruction(migraphx::op::transpose{{1, 0}}, x);
+    auto r  = p.add_instruction(migraphx::op::relu{}, xt);
+    p.add_instruction(migraphx::op::dot{}, r, x);
+    p.compile(migraphx::cpu::target{});
+    EXPECT(std::none_of(
+        p.begin(), p.end(), [](auto&& ins) { return ins.name() == "cpu::contiguous"; }));
+
+    std::vector<float> xdata = {-1, 2, -3, 4, -5, 6};
+    auto result              = p.eval({{"x", migraphx::argument{s, xdata.data()}}});
+    std::vector<float> results_vector;
+    result.visit([&](auto output) { results_vector.assign(output.begin(), output.end()); });
+    // relu(x^T) = {{0, 4}, {2, 0}, {0, 6}}
+    std::vector<float> gold = {16, -20, 24, -2, 4, -6, 24, -30, 36};
+    EXPECT(migraphx::verify_range(results_vector, gold));
+}
+
+TEST_CASE(save_load_compiled_test)
+{
+    std::string filename = "cpu_ops_test_save_load_compiled.mxr";
+    migraphx::program p1;
+    migraphx::shape xs{migraphx::shape::float_type, {1, 3, 6, 6}};
+    migraphx::shape ws{migraphx::shape::float_type, {4, 3, 3, 3}};
+    auto x = p1.add_parameter("x", xs);
+    std::vector<float> wdata(ws.elements());
+    std::iota(wdata.begin(), wdata.end(), -50);
+    auto w    = p1.add_literal(migraphx::literal{ws, wdata});
+    auto conv = p1.add_instruction(migraphx::op::convolution{{{1, 1}}}, x, w);
+    auto r    = p1.add_instruction(migraphx::op::relu{}, conv);
+    p1.add_instruction(migraphx::op::pooling{"max", {{0, 0}}, {{2, 2}}, {{2, 2}}}, r);
+    p1.compile(migraphx::cpu::target{});
+    p1.save(filename);
+    auto p2 = migraphx::load(filename, migraphx::cpu::target{});
+    EXPECT(test::throws([&] { migraphx::load(filename); }));
+    std::remove(filename.c_str());
+    EXPECT(p1 == p2);
+
+    std::vector<float> data(xs.elements());
+    std::iota(data.begin(), data.end(), 0);
+    auto run = [&](const migraphx::program& p) {
+        auto result = p.eval({{"x", migraphx::argument{xs, data.data()}}});
+        std::vector<float> results_vector;
+        result.visit([&](auto output) { results_vector.assign(output.begin(), output.end()); });
+        return results_vector;
+    };
+    EXPECT(migraphx::verify_range(run(p1), run(p2)));
+}
+
+TEST_CASE(quantizelinear_test)
+{
+    migraphx::program p;
+    migraphx::shape s{migraphx::shape::float_type, {2, 4}};
+    std::vector<float> data = {-2.0f, -0.3f, 0.25f, 0.75f, 1.25f, 63.0f, 100.0f, -100.0f};
+    auto x = p.add_parameter("x", s);
+    auto t = p.add_instruction(migraphx::op::transpose{{1, 0}}, x);
+    auto q = p.add_instruction(migraphx::op::quantizelinear{0.5f}, t);
+    p.add_instruction(migraphx::op::dequantizelinear{0.5f, 1}, q);
+    p.compile(migraphx::cpu::target{});
+    auto result = p.eval({{"x", migraphx::argument{s, data.data()}}});
+    std::vector<float> results_vector;
+    result.visit([&](auto output) { results_vector.assign(output.begin(), output.end()); });
+    // Ties round to even, and values out of range saturate
+    std::vector<float> gold = {-2.5f, 0.5f, -1.0f, 62.5f, -0.5f, 63.0f, 0.5f, -64.5f};
+    EXPECT(migraphx::verify_range(results_vector, gold));
+}
+
+TEST_CASE(quant_dot_test)
+{
+    const std::size_t m = 7;
+    const std::size_t n = 37;
+    const std::size_t k = 300;
+    migraphx::shape as{migraphx::shape::int8_type, {2, m, k}};
+    migraphx::shape bs{migraphx::shape::int8_type, {2, n, k}};
+    std::vector<int8_t> a(as.elements());
+    std::vector<int8_t> b(bs.elements());
+    for(std::size_t i = 0; i < a.size(); i++)
+        a[i] = int8_t(int(i * 37 % 255) - 127);
+    for(std::size_t i = 0; i < b.size(); i++)
+        b[i] = int8_t(int(i * 91 % 255) - 128);
+
+    migraphx::program p;
+    auto al = p.add_literal(migraphx::literal{as, a});
+    auto bl = p.add_literal(migraphx::literal{bs, b});
+    auto bt = p.add_instruction(migraphx::op::transpose{{0, 2, 1}}, bl);
+    p.add_instruction(migraphx::op::quant_dot{}, al, bt);
+    p.compile(migraphx::cpu::target{});
+    auto result = p.eval({});
+    EXPECT(result.get_shape().type() == migraphx::shape::int32_type);
+    std::vector<int32_t> results_vector;
+    result.visit([&](auto output) { results_vector.assign(output.begin(), output.end()); });
+
+    // The products are accumulated exactly
+    std::vector<int32_t> gold(2 * m * n);
+    for(std::size_t g = 0; g < 2; g++)
+        for(std::size_t i = 0; i < m; i++)
+            for(std::size_t j = 0; j < n; j++)
+            {
+                int32_t sum = 0;
+                for(std::size_t x = 0; x < k; x++)
+                    sum += a[(g * m + i) * k + x] * b[(g * n + j) * k + x];
+                gold[(g * m + i) * n + j] = sum;
+            }
+    EXPECT(results_vector == gold);
+}
+
+TEST_CASE(quant_conv_test)
+{
+    migraphx::shape xs{migraphx::shape::int8_type, {2, 4, 7, 7}};
+    migraphx::shape ws{migraphx::shape::int8_type, {6, 2, 3, 3}};
+    std::vector<int8_t> x(xs.elements());
+    std::vector<int8_t> w(ws.elements());
+    for(std::size_t i = 0; i < x.size(); i++)
+        x[i] = int8_t(int(i * 37 % 255) - 127);
+    for(std::size_t i = 0; i < w.size(); i++)
+        w[i] = int8_t(int(i * 91 % 255) - 128);
+
+    migraphx::op::quant_convolution op;
+    op.padding = {{1, 1}};
+    op.stride  = {{2, 2}};
+    op.group   = 2;
+    migraphx::program p;
+    auto xl = p.add_literal(migraphx::literal{xs, x});
+    auto wl = p.add_literal(migraphx::literal{ws, w});
+    p.add_instruction(op, xl, wl);
+    p.compile(migraphx::cpu::target{});
+    auto result = p.eval({});
+    std::vector<int32_t> results_vector;
+    result.visit([&](auto output) { results_vector.assign(output.begin(), output.end()); });
+
+    std::vector<int32_t> gold;
+    for(std::size_t b = 0; b < 2; b++)
+        for(std::size_t oc = 0; oc < 6; oc++)
+            for(int i = 0; i < 4; i++)
+                for(int j = 0; j < 4; j++)
+                {
+                    int32_t sum = 0;
+                    for(std::size_t c = 0; c < 2; c++)
+                        for(int kh = 0; kh < 3; kh++)
+                            for(int kw = 0; kw < 3; kw++)
+                            {
+                                int ih = i * 2 + kh - 1;
+                                int iw = j * 2 + kw - 1;
+                                if(ih < 0 or ih >= 7 or iw < 0 or iw >= 7)
+                                    continue;
+                                auto ic = (oc / 3) * 2 + c;
+                                sum += x[((b * 4 + ic) * 7 + ih) * 7 + iw] *
+                                       w[((oc * 2 + c) * 3 + kh) * 3 + kw];
+                            }
+                    gold.push_back(sum);
+                }
+    EXPECT(results_vector == gold);
+}
+
 int main(int argc, const char* argv[]) { test::run(argc, argv); }
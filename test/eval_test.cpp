@@ -288,6 +288,51 @@ TEST_CASE(double_reverse_target_test)
     EXPECT(result != migraphx::literal{4});
 }
 
+TEST_CASE(compiled_replace_test)
+{
+    migraphx::program p;
+
+    auto x   = p.add_parameter("x", {migraphx::shape::int32_type});
+    auto two = p.add_literal(2);
+    auto sum = p.add_instruction(sum_op{}, x, two);
+    p.compile(id_target{});
+    EXPECT(p.eval({{"x", migraphx::literal{1}.get_argument()}}) == migraphx::literal{3});
+    // Changing the program after it is compiled is seen by eval
+    p.replace_instruction(sum, minus_op{}, x, two);
+    EXPECT(p.eval({{"x", migraphx::literal{5}.get_argument()}}) == migraphx::literal{3});
+    p.add_instruction(sum_op{}, sum, sum);
+    EXPECT(p.eval({{"x", migraphx::literal{5}.get_argument()}}) == migraphx::literal{6});
+}
+
+TEST_CASE(compiled_copy_test)
+{
+    migraphx::program p1;
+
+    auto one = p1.add_literal(1);
+    auto two = p1.add_literal(2);
+    p1.add_instruction(sum_op{}, one, two);
+    p1.compile(id_target{});
+    migraphx::program p2 = p1;
+    EXPECT(p2.eval({}) == migraphx::literal{3});
+    EXPECT(p1.eval({}) == migraphx::literal{3});
+}
+
+TEST_CASE(compiled_param_error_test)
+{
+    migraphx::program p;
+
+    auto x = p.add_parameter("x", {migraphx::shape::int32_type});
+    auto y = p.add_parameter("y", {migraphx::shape::int32_type});
+
+    p.add_instruction(sum_op{}, x, y);
+    p.compile(id_target{});
+    EXPECT(test::throws<migraphx::exception>(
+        [&] {
+            p.eval({{"x", migraphx::literal{1}.get_argument()}});
+        },
+        "Parameter not found: y"));
+}
+
 // Check that the program doesnt modify the context directly, and only the operators modify the
 // context
 TEST_CASE(eval_context1)
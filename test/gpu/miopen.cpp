@@ -100,7 +100,8 @@ migraphx::argument run_cpu(migraphx::program& p)
     V v;
     p = v.create_program();
     auto_print pp{p, 0};
-    compile_check(p, migraphx::cpu::target{});
+    // The reference results are accumulated in double
+    compile_check(p, migraphx::cpu::target{migraphx::cpu::accumulate::double_precision});
     migraphx::program::parameter_map m;
     for(auto&& x : p.get_parameter_shapes())
     {
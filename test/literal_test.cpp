@@ -25,6 +25,18 @@ TEST_CASE(literal_test)
     EXPECT(l4.empty());
 }
 
+TEST_CASE(literal_argument_no_copy)
+{
+    migraphx::shape s{migraphx::shape::float_type, {2, 3}};
+    migraphx::literal l{s, {1, 2, 3, 4, 5, 6}};
+    EXPECT(l.get_argument().data() == l.data());
+
+    migraphx::argument a{s};
+    migraphx::literal la{a};
+    EXPECT(la.data() == a.data());
+    EXPECT(la.get_shape() == s);
+}
+
 TEST_CASE(literal_os1)
 {
     migraphx::literal l{1};
@@ -557,6 +557,30 @@ TEST_CASE(constant_fill_test)
     }
 }
 
+TEST_CASE(initializer_raw_data_test)
+{
+    migraphx::program p;
+    migraphx::shape s{migraphx::shape::float_type, {2, 3}};
+    auto l0 = p.add_parameter("x", s);
+    auto l1 = p.add_literal(migraphx::literal{s, {1, 2, 3, 4, 5, 6}});
+    p.add_instruction(migraphx::op::add{}, l0, l1);
+    auto prog = migraphx::parse_onnx("initializer_raw_data_test.onnx");
+
+    EXPECT(p == prog);
+}
+
+TEST_CASE(external_data_test)
+{
+    migraphx::program p;
+    migraphx::shape s{migraphx::shape::float_type, {2, 3}};
+    auto l0 = p.add_parameter("x", s);
+    auto l1 = p.add_literal(migraphx::literal{s, {1, 2, 3, 4, 5, 6}});
+    p.add_instruction(migraphx::op::add{}, l0, l1);
+    auto prog = migraphx::parse_onnx("external_data_test.onnx");
+
+    EXPECT(p == prog);
+}
+
 TEST_CASE(gemm_test)
 {
     migraphx::program p;
@@ -76,6 +76,53 @@ TEST_CASE(convolution_shape)
     throws_shape(migraphx::op::convolution{}, input2, weights);
 }
 
+TEST_CASE(quant_convolution_shape)
+{
+    migraphx::shape output{migraphx::shape::int32_type, {4, 4, 1, 1}};
+    migraphx::shape input{migraphx::shape::int8_type, {4, 3, 3, 3}};
+    migraphx::shape weights{migraphx::shape::int8_type, {4, 3, 3, 3}};
+    expect_shape(output, migraphx::op::quant_convolution{}, input, weights);
+    throws_shape(migraphx::op::quant_convolution{}, input);
+
+    migraphx::shape input2{migraphx::shape::float_type, {4, 3, 3, 3}};
+    migraphx::shape weights2{migraphx::shape::float_type, {4, 3, 3, 3}};
+    throws_shape(migraphx::op::quant_convolution{}, input2, weights2);
+    throws_shape(migraphx::op::quant_convolution{}, input, weights2);
+}
+
+TEST_CASE(quant_dot_shape)
+{
+    migraphx::shape a{migraphx::shape::int8_type, {2, 4, 5}};
+    migraphx::shape b{migraphx::shape::int8_type, {2, 5, 8}};
+    expect_shape(migraphx::shape{migraphx::shape::int32_type, {2, 4, 8}},
+                 migraphx::op::quant_dot{},
+                 a,
+                 b);
+    throws_shape(migraphx::op::quant_dot{}, a, a);
+    throws_shape(migraphx::op::quant_dot{}, a, b, b);
+
+    migraphx::shape fa{migraphx::shape::float_type, {4, 5}};
+    migraphx::shape fb{migraphx::shape::float_type, {5, 8}};
+    throws_shape(migraphx::op::quant_dot{}, fa, fb);
+}
+
+TEST_CASE(quantizelinear_shape)
+{
+    migraphx::shape input{migraphx::shape::float_type, {2, 3}, {1, 2}};
+    expect_shape(migraphx::shape{migraphx::shape::int8_type, {2, 3}},
+                 migraphx::op::quantizelinear{},
+                 input);
+    expect_shape(migraphx::shape{migraphx::shape::float_type, {2, 3}},
+                 migraphx::op::dequantizelinear{},
+                 migraphx::shape{migraphx::shape::int8_type, {2, 3}});
+    expect_shape(migraphx::shape{migraphx::shape::float_type, {2, 3}},
+                 migraphx::op::dequantizelinear{},
+                 migraphx::shape{migraphx::shape::int32_type, {2, 3}});
+    throws_shape(migraphx::op::quantizelinear{},
+                 migraphx::shape{migraphx::shape::int8_type, {2, 3}});
+    throws_shape(migraphx::op::dequantizelinear{}, input);
+}
+
 TEST_CASE(transpose_shape)
 {
     migraphx::shape input{migraphx::shape::float_type, {2, 2}};
@@ -346,6 +393,32 @@ TEST_CASE(gather)
     }
 }
 
+TEST_CASE(softmax)
+{
+    {
+        migraphx::shape input{migraphx::shape::float_type, {2, 3, 4, 5}};
+        expect_shape(input, migraphx::op::softmax{}, input);
+    }
+
+    {
+        migraphx::shape input{migraphx::shape::float_type, {2, 30}};
+        int axis = 1;
+        expect_shape(input, migraphx::op::softmax{axis}, input);
+    }
+
+    {
+        migraphx::shape input{migraphx::shape::float_type, {2, 3, 4}};
+        int axis = 3;
+        throws_shape(migraphx::op::softmax{axis}, input);
+    }
+
+    {
+        migraphx::shape input{migraphx::shape::float_type, {2, 3, 4}};
+        int axis = -1;
+        throws_shape(migraphx::op::softmax{axis}, input);
+    }
+}
+
 TEST_CASE(logsoftmax)
 {
     {
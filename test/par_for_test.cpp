@@ -0,0 +1,72 @@
+#include <migraphx/par_for.hpp>
+#include <migraphx/par_dfor.hpp>
+#include <migraphx/thread_pool.hpp>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include "test.hpp"
+
+TEST_CASE(par_for_visits_all)
+{
+    std::vector<int> data(1000, 0);
+    migraphx::par_for(data.size(), 1, [&](std::size_t i) { data[i] += 1; });
+    EXPECT(std::all_of(data.begin(), data.end(), [](int x) { return x == 1; }));
+}
+
+TEST_CASE(par_for_reuse)
+{
+    std::vector<int> data(257, 0);
+    for(int k = 0; k < 50; k++)
+        migraphx::par_for(data.size(), 1, [&](std::size_t i) { data[i] += 1; });
+    EXPECT(std::all_of(data.begin(), data.end(), [](int x) { return x == 50; }));
+}
+
+TEST_CASE(par_for_nested)
+{
+    std::atomic<std::size_t> count{0};
+    migraphx::par_for(64, 1, [&](std::size_t) {
+        migraphx::par_for(64, 1, [&](std::size_t) { count++; });
+    });
+    EXPECT(count == 64 * 64);
+}
+
+TEST_CASE(par_dfor_indices)
+{
+    std::vector<std::size_t> data(4 * 5 * 6, 0);
+    migraphx::par_dfor(4, 5, 6)(
+        [&](std::size_t i, std::size_t j, std::size_t k) { data[i * 30 + j * 6 + k] += 1; });
+    EXPECT(std::all_of(data.begin(), data.end(), [](std::size_t x) { return x == 1; }));
+}
+
+TEST_CASE(thread_pool_chunks)
+{
+    migraphx::thread_pool pool{4};
+    EXPECT(pool.size() == 4);
+    std::vector<int> data(103, 0);
+    pool.parallel_for(data.size(), 10, 4, [&](std::size_t start, std::size_t last) {
+        EXPECT(last - start <= 10);
+        for(std::size_t i = start; i < last; i++)
+            data[i] += 1;
+    });
+    EXPECT(std::all_of(data.begin(), data.end(), [](int x) { return x == 1; }));
+}
+
+TEST_CASE(thread_pool_exception)
+{
+    migraphx::thread_pool pool{3};
+    EXPECT(test::throws([&] {
+        pool.parallel_for(100, 1, 3, [&](std::size_t start, std::size_t) {
+            if(start == 50)
+                throw std::runtime_error("error");
+        });
+    }));
+    // The pool is still usable after an error
+    std::atomic<std::size_t> count{0};
+    pool.parallel_for(100, 1, 3, [&](std::size_t start, std::size_t last) {
+        count += last - start;
+    });
+    EXPECT(count == 100);
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }
@@ -3,6 +3,8 @@
 #include <migraphx/op/add.hpp>
 #include <migraphx/op/scalar.hpp>
 #include <migraphx/op/mul.hpp>
+#include <migraphx/op/reshape.hpp>
+#include <migraphx/instruction.hpp>
 #include <basic_ops.hpp>
 #include <test.hpp>
 
@@ -112,4 +114,42 @@ TEST_CASE(const_scalar)
     EXPECT(p1 == p2);
 }
 
+TEST_CASE(const_independent)
+{
+    migraphx::program p1;
+    {
+        auto one  = p1.add_literal(1);
+        auto two  = p1.add_literal(2);
+        auto sum  = p1.add_instruction(migraphx::op::add{}, one, two);
+        auto mul  = p1.add_instruction(migraphx::op::mul{}, two, two);
+        auto sum2 = p1.add_instruction(migraphx::op::add{}, sum, two);
+        p1.add_instruction(pass_op{}, sum2, mul);
+    }
+    p1.compile(const_prop_target{});
+
+    migraphx::program p2;
+    {
+        auto four = p2.add_literal(4);
+        auto five = p2.add_literal(5);
+        p2.add_instruction(pass_op{}, five, four);
+    }
+    EXPECT(p1 == p2);
+}
+
+TEST_CASE(const_reshape_no_copy)
+{
+    migraphx::program p1;
+    migraphx::shape s{migraphx::shape::float_type, {2, 3}};
+    auto l           = p1.add_literal(migraphx::literal{s, {1, 2, 3, 4, 5, 6}});
+    const char* data = l->get_literal().data();
+    auto r           = p1.add_instruction(migraphx::op::reshape{{3, 2}}, l);
+    p1.add_instruction(pass_op{}, r);
+    p1.compile(const_prop_target{});
+
+    auto folded = std::prev(p1.end(), 2);
+    EXPECT(folded->name() == "@literal");
+    EXPECT(folded->get_shape() == migraphx::shape{migraphx::shape::float_type, {3, 2}});
+    EXPECT(folded->get_literal().data() == data);
+}
+
 int main(int argc, const char* argv[]) { test::run(argc, argv); }
@@ -0,0 +1,136 @@
+#include <migraphx/quantization.hpp>
+#include <migraphx/program.hpp>
+#include <migraphx/operators.hpp>
+#include <migraphx/instruction.hpp>
+#include <migraphx/iterator_for.hpp>
+#include <migraphx/generate.hpp>
+#include <migraphx/verify.hpp>
+#include <migraphx/cpu/target.hpp>
+#include <algorithm>
+#include <cmath>
+#include <test.hpp>
+
+std::vector<float> run(migraphx::program p, const migraphx::program::parameter_map& params)
+{
+    p.compile(migraphx::cpu::target{});
+    auto result = p.eval(params);
+    std::vector<float> results_vector;
+    result.visit([&](auto output) { results_vector.assign(output.begin(), output.end()); });
+    return results_vector;
+}
+
+// The error of int8 values is about 1% of the range of the inputs
+bool near_range(const std::vector<float>& x, const std::vector<float>& gold)
+{
+    float range = 0.0f;
+    float error = 0.0f;
+    for(std::size_t i = 0; i < gold.size(); i++)
+    {
+        range = std::max(range, std::abs(gold[i]));
+        error = std::max(error, std::abs(x[i] - gold[i]));
+    }
+    return x.size() == gold.size() and error <= 0.05f * range;
+}
+
+bool has_instruction(const migraphx::program& p, const std::string& name)
+{
+    return std::any_of(
+        p.begin(), p.end(), [&](const migraphx::instruction& ins) { return ins.name() == name; });
+}
+
+migraphx::program create_model()
+{
+    migraphx::program p;
+    migraphx::shape xs{migraphx::shape::float_type, {2, 3, 8, 8}};
+    migraphx::shape w1s{migraphx::shape::float_type, {4, 3, 3, 3}};
+    migraphx::shape w2s{migraphx::shape::float_type, {64, 10}};
+    migraphx::shape cs{migraphx::shape::float_type, {2, 10}};
+    auto x    = p.add_parameter("x", xs);
+    auto w1   = p.add_literal(migraphx::generate_literal(w1s, 1));
+    auto w2   = p.add_literal(migraphx::generate_literal(w2s, 2));
+    auto c    = p.add_literal(migraphx::generate_literal(cs, 3));
+    auto conv = p.add_instruction(migraphx::op::convolution{{{1, 1}}, {{2, 2}}}, x, w1);
+    auto relu = p.add_instruction(migraphx::op::relu{}, conv);
+    auto flat = p.add_instruction(migraphx::op::flatten{1}, relu);
+    p.add_instruction(migraphx::op::dot{2.0f, 0.5f}, flat, w2, c);
+    return p;
+}
+
+TEST_CASE(capture_ranges)
+{
+    migraphx::program p;
+    migraphx::shape s{migraphx::shape::float_type, {2, 2}};
+    auto x = p.add_parameter("x", s);
+    auto w = p.add_literal(migraphx::literal{s, {1.0f, -3.0f, 2.0f, 0.5f}});
+    auto y = p.add_instruction(migraphx::op::relu{}, x);
+    p.add_instruction(migraphx::op::dot{}, y, w);
+
+    std::vector<float> x1 = {1.0f, -7.0f, 2.0f, 0.0f};
+    std::vector<float> x2 = {-9.0f, 4.0f, 0.5f, -1.0f};
+    std::vector<migraphx::program::parameter_map> calibration(2);
+    calibration[0]["x"] = migraphx::argument{s, x1.data()};
+    calibration[1]["x"] = migraphx::argument{s, x2.data()};
+    auto ranges         = migraphx::capture_ranges(p, migraphx::cpu::target{}, calibration);
+    // The ranges are taken after the relu, and the program is not modified
+    EXPECT(ranges == std::vector<float>{4.0f, 3.0f});
+    EXPECT(not has_instruction(p, "capture"));
+}
+
+TEST_CASE(quantize_dot)
+{
+    migraphx::program p;
+    migraphx::shape s{migraphx::shape::float_type, {3, 4}};
+    auto x = p.add_parameter("x", s);
+    auto w = p.add_literal(migraphx::literal{s, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12}});
+    auto t = p.add_instruction(migraphx::op::transpose{{1, 0}}, w);
+    p.add_instruction(migraphx::op::dot{0.5f, 0.0f}, x, t);
+    migraphx::quantize_int8(p, {127.0f, 12.7f});
+    EXPECT(has_instruction(p, "quant_dot"));
+    EXPECT(not has_instruction(p, "dot"));
+
+    // The inputs are exact multiples of the scales
+    std::vector<float> data = {0, 1, 2, 3, -1, -2, -3, -4, 10, 20, 30, 40};
+    std::vector<float> gold = {10, 22, 34, -15, -35, -55, 150, 350, 550};
+    EXPECT(migraphx::verify_range(run(p, {{"x", migraphx::argument{s, data.data()}}}), gold));
+}
+
+TEST_CASE(quantize_model)
+{
+    auto p = create_model();
+    std::vector<migraphx::program::parameter_map> calibration;
+    std::vector<migraphx::argument> samples;
+    for(std::size_t i = 0; i < 3; i++)
+    {
+        samples.push_back(migraphx::generate_argument(p.get_parameter_shape("x"), i));
+        calibration.push_back({{"x", samples.back()}});
+    }
+
+    auto q = p;
+    migraphx::quantize_int8(q, migraphx::cpu::target{}, calibration);
+    EXPECT(has_instruction(q, "quant_convolution"));
+    EXPECT(has_instruction(q, "quant_dot"));
+    EXPECT(not has_instruction(q, "convolution"));
+    EXPECT(not has_instruction(q, "dot"));
+
+    for(auto&& params : calibration)
+        EXPECT(near_range(run(q, params), run(p, params)));
+
+    // The weights are stored as int8 literals once the program is compiled
+    q.compile(migraphx::cpu::target{});
+    EXPECT(std::none_of(q.begin(), q.end(), [](const migraphx::instruction& ins) {
+        return ins.name() == "@literal" and
+               ins.get_shape().type() == migraphx::shape::float_type and
+               ins.get_shape().elements() > 100;
+    }));
+}
+
+TEST_CASE(quantize_names)
+{
+    auto p = create_model();
+    migraphx::quantize_int8(p, {1.0f, 1.0f}, {"convolution"});
+    EXPECT(has_instruction(p, "quant_convolution"));
+    EXPECT(has_instruction(p, "dot"));
+    EXPECT(test::throws([&] { migraphx::quantize_int8(p, {1.0f}, {"dot"}); }));
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }
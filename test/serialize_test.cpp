@@ -0,0 +1,156 @@
+#include <migraphx/program.hpp>
+#include <migraphx/serialize.hpp>
+#include <migraphx/operators.hpp>
+#include <migraphx/instruction.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include "test.hpp"
+
+// Removes the file when the test is done
+struct temp_file
+{
+    std::string name;
+    explicit temp_file(std::string n) : name(std::move(n)) {}
+    temp_file(const temp_file&) = delete;
+    temp_file& operator=(const temp_file&) = delete;
+    ~temp_file() { std::remove(name.c_str()); }
+};
+
+migraphx::program create_program()
+{
+    migraphx::program p;
+    migraphx::shape xs{migraphx::shape::float_type, {1, 3, 8, 8}};
+    migraphx::shape ws{migraphx::shape::float_type, {4, 3, 3, 3}};
+    auto x = p.add_parameter("x", xs);
+    std::vector<float> wdata(ws.elements());
+    std::iota(wdata.begin(), wdata.end(), 0);
+    auto w    = p.add_literal(migraphx::literal{ws, wdata});
+    auto conv = p.add_instruction(migraphx::op::convolution{{{1, 1}}, {{2, 2}}}, x, w);
+    auto b    = p.add_literal(migraphx::literal{{migraphx::shape::float_type, {4}}, {1, 2, 3, 4}});
+    auto bb   = p.add_instruction(migraphx::op::broadcast{1, conv->get_shape().lens()}, b);
+    auto sum  = p.add_instruction(migraphx::op::add{}, conv, bb);
+    auto t    = p.add_instruction(migraphx::op::transpose{{0, 2, 3, 1}}, sum);
+    p.add_instruction(migraphx::op::pooling{"max"}, p.add_instruction(migraphx::op::relu{}, t));
+    return p;
+}
+
+TEST_CASE(save_load)
+{
+    temp_file f{"serialize_test_save_load.mxr"};
+    auto p1 = create_program();
+    p1.save(f.name);
+    auto p2 = migraphx::load(f.name);
+    EXPECT(p1 == p2);
+}
+
+TEST_CASE(save_load_rnn)
+{
+    temp_file f{"serialize_test_save_load_rnn.mxr"};
+    migraphx::program p1;
+    migraphx::shape in_shape{migraphx::shape::float_type, {1, 2, 3}};
+    migraphx::shape w_shape{migraphx::shape::float_type, {1, 16, 3}};
+    migraphx::shape r_shape{migraphx::shape::float_type, {1, 16, 4}};
+    auto x = p1.add_parameter("x", in_shape);
+    auto w = p1.add_parameter("w", w_shape);
+    auto r = p1.add_parameter("r", r_shape);
+    p1.add_instruction(migraphx::op::lstm{4,
+                                          {migraphx::op::sigmoid{},
+                                           migraphx::op::tanh{},
+                                           migraphx::op::relu{}},
+                                          migraphx::op::rnn_direction::reverse,
+                                          0.5f},
+                       x,
+                       w,
+                       r);
+    p1.save(f.name);
+    auto p2 = migraphx::load(f.name);
+    EXPECT(p1 == p2);
+    auto lstm = std::prev(p2.end());
+    EXPECT(lstm->get_operator() == std::prev(p1.end())->get_operator());
+}
+
+TEST_CASE(load_literal)
+{
+    temp_file f{"serialize_test_load_literal.mxr"};
+    migraphx::program p1;
+    migraphx::shape s{migraphx::shape::int32_type, {2, 3}};
+    p1.add_literal(migraphx::literal{s, {1, 2, 3, 4, 5, 6}});
+    p1.add_literal(migraphx::literal{s, {6, 5, 4, 3, 2, 1}});
+    p1.save(f.name);
+    auto p2 = migraphx::load(f.name);
+    EXPECT(p1 == p2);
+    std::vector<migraphx::literal> literals;
+    for(auto&& ins : p2)
+        literals.push_back(ins.get_literal());
+    // Literals are added to the front of the program
+    EXPECT(literals.size() == 2);
+    EXPECT(literals[0] == migraphx::literal{s, {6, 5, 4, 3, 2, 1}});
+    EXPECT(literals[1] == migraphx::literal{s, {1, 2, 3, 4, 5, 6}});
+    // The literals are used from the file without a copy
+    EXPECT(reinterpret_cast<std::uintptr_t>(literals[0].data()) % 64 == 0);
+}
+
+TEST_CASE(load_missing_file)
+{
+    EXPECT(test::throws([&] { migraphx::load("serialize_test_missing_file.mxr"); }));
+}
+
+TEST_CASE(load_invalid_file)
+{
+    temp_file f{"serialize_test_invalid_file.mxr"};
+    {
+        std::ofstream os(f.name);
+        os << "not a program";
+    }
+    EXPECT(test::throws<migraphx::exception>([&] { migraphx::load(f.name); },
+                                             "Not a program file"));
+}
+
+TEST_CASE(load_truncated_file)
+{
+    temp_file f{"serialize_test_truncated_file.mxr"};
+    auto p = create_program();
+    p.save(f.name);
+    std::string contents;
+    {
+        std::ifstream is(f.name, std::ios::binary);
+        std::stringstream ss;
+        ss << is.rdbuf();
+        contents = ss.str();
+    }
+    {
+        std::ofstream os(f.name, std::ios::binary);
+        os.write(contents.data(), contents.size() / 4);
+    }
+    EXPECT(test::throws<migraphx::exception>([&] { migraphx::load(f.name); }));
+}
+
+TEST_CASE(serialize_values)
+{
+    std::stringstream ss;
+    migraphx::binary_writer w{&ss};
+    migraphx::shape s{migraphx::shape::half_type, {2, 3}, {1, 2}};
+    std::vector<std::string> strings = {"a", "", "abc"};
+    migraphx::serialize(w, s);
+    migraphx::serialize(w, strings);
+    migraphx::serialize(w, migraphx::op::pooling{"average", {{1, 1}}, {{2, 2}}, {{3, 3}}});
+    auto data = ss.str();
+
+    migraphx::binary_reader r{data.data(), data.size()};
+    migraphx::shape s2;
+    std::vector<std::string> strings2;
+    migraphx::op::pooling pooling;
+    migraphx::deserialize(r, s2);
+    migraphx::deserialize(r, strings2);
+    migraphx::deserialize(r, pooling);
+    EXPECT(s == s2);
+    EXPECT(strings == strings2);
+    EXPECT(migraphx::operation{pooling} ==
+           migraphx::operation{migraphx::op::pooling{"average", {{1, 1}}, {{2, 2}}, {{3, 3}}}});
+    EXPECT(r.offset == data.size());
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }
@@ -0,0 +1,100 @@
+#include <migraphx/shape_for_each.hpp>
+#include <migraphx/par_shape_for_each.hpp>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include "test.hpp"
+
+std::vector<std::size_t> indices_of(const migraphx::shape& s)
+{
+    std::vector<std::size_t> result;
+    migraphx::shape_for_each(s, [&](const auto& idx) { result.push_back(s.index(idx)); });
+    return result;
+}
+
+// The offsets of every element in the standard order, computed with division
+std::vector<std::size_t> reference_offsets(const migraphx::shape& s)
+{
+    std::vector<std::size_t> result;
+    for(std::size_t i = 0; i < s.elements(); i++)
+        result.push_back(s.index(i));
+    return result;
+}
+
+std::vector<std::size_t> walk_offsets(const migraphx::shape& s)
+{
+    migraphx::shape standard{s.type(), s.lens()};
+    std::vector<std::size_t> result;
+    migraphx::for_each_offset(standard, s)([&](auto i, auto j) {
+        EXPECT(i == result.size());
+        result.push_back(j);
+    });
+    return result;
+}
+
+TEST_CASE(shape_for_each_standard)
+{
+    migraphx::shape s{migraphx::shape::float_type, {2, 3, 4}};
+    std::vector<std::size_t> expected(s.elements());
+    std::iota(expected.begin(), expected.end(), 0);
+    EXPECT(indices_of(s) == expected);
+}
+
+TEST_CASE(shape_for_each_transposed)
+{
+    // Transposed shapes are visited in memory order
+    migraphx::shape s{migraphx::shape::float_type, {3, 2}, {1, 3}};
+    std::vector<std::size_t> expected{0, 1, 2, 3, 4, 5};
+    EXPECT(indices_of(s) == expected);
+}
+
+TEST_CASE(shape_for_each_all_indices)
+{
+    migraphx::shape s{migraphx::shape::float_type, {2, 3, 4}, {1, 8, 2}};
+    std::vector<std::vector<std::size_t>> visited;
+    migraphx::shape_for_each(s, [&](const auto& idx) { visited.push_back(idx); });
+    EXPECT(visited.size() == s.elements());
+    std::sort(visited.begin(), visited.end());
+    EXPECT(bool{std::adjacent_find(visited.begin(), visited.end()) == visited.end()});
+}
+
+TEST_CASE(for_each_offset_standard)
+{
+    migraphx::shape s{migraphx::shape::float_type, {2, 3, 4}};
+    EXPECT(walk_offsets(s) == reference_offsets(s));
+}
+
+TEST_CASE(for_each_offset_transposed)
+{
+    migraphx::shape s{migraphx::shape::float_type, {2, 3, 4}, {1, 8, 2}};
+    EXPECT(walk_offsets(s) == reference_offsets(s));
+}
+
+TEST_CASE(for_each_offset_broadcast)
+{
+    migraphx::shape s{migraphx::shape::float_type, {2, 3, 4, 5}, {0, 1, 0, 0}};
+    EXPECT(walk_offsets(s) == reference_offsets(s));
+}
+
+TEST_CASE(for_each_offset_sliced)
+{
+    migraphx::shape s{migraphx::shape::float_type, {2, 3, 1, 4}, {40, 10, 5, 1}};
+    EXPECT(walk_offsets(s) == reference_offsets(s));
+}
+
+TEST_CASE(for_each_offset_scalar)
+{
+    migraphx::shape s{migraphx::shape::float_type, {1}, {0}};
+    EXPECT(walk_offsets(s) == reference_offsets(s));
+}
+
+TEST_CASE(par_for_each_offset_large)
+{
+    migraphx::shape s{migraphx::shape::float_type, {7, 33, 65}, {1, 7 * 65, 7}};
+    migraphx::shape standard{s.type(), s.lens()};
+    std::vector<std::size_t> result(s.elements());
+    migraphx::par_for_each_offset(standard, s)([&](auto i, auto j) { result[i] = j; });
+    EXPECT(result == reference_offsets(s));
+}
+
+int main(int argc, const char* argv[]) { test::run(argc, argv); }